@@ -14,11 +14,13 @@
 #include "boot_cpu.h"
 #include "paging.h"
 #include "load_elf.h"
+#include "lz4.h"
 #include "mm_alloc.h"
 #include "support.h"
 
 extern unsigned KERNEL_CS_64;
 extern char _binary_bootstrap64_bin_start;
+extern char _binary_bootstrap64_bin_end;
 extern char _image_start;
 extern char _image_end;
 
@@ -78,7 +80,8 @@ bootstrap (l4util_mb_info_t *mbi, unsigned int flag, char *rm_pointer)
   // our memory available for our initial identity mapped page table is
   // enough to cover 4GB of physical memory that must contain anything that
   // is required to boot, i.e. bootstrap, all modules, any required devices
-  // and the final location of sigma0 and moe
+  // and the final location of sigma0 and moe; bootstrap64 maps the remaining
+  // RAM once it knows the memory map to place modules there
   const unsigned long long Max_initial_mem = 4ull << 30;
 
   // Make sure future allocations do not overwrite our image
@@ -116,7 +119,13 @@ bootstrap (l4util_mb_info_t *mbi, unsigned int flag, char *rm_pointer)
   printf("Loading 64bit part...\n");
   // switch from 32 Bit compatibility mode to 64 Bit mode
   far_ptr.cs    = KERNEL_CS_64;
-  far_ptr.start = load_elf(&_binary_bootstrap64_bin_start);
+  unsigned long bootstrap64_size
+    = &_binary_bootstrap64_bin_end - &_binary_bootstrap64_bin_start;
+  if (lz4_is_legacy(&_binary_bootstrap64_bin_start, bootstrap64_size))
+    far_ptr.start = load_elf_lz4(&_binary_bootstrap64_bin_start,
+                                 bootstrap64_size, mem_upper);
+  else
+    far_ptr.start = load_elf(&_binary_bootstrap64_bin_start);
 
   asm volatile("ljmp *(%4)"
                 :: "D"(mbi), "S"(flag), "d"(rm_pointer),
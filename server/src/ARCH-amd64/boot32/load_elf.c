@@ -11,15 +11,29 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <l4/sys/consts.h>
 #include <l4/util/elf.h>
 
 #include "load_elf.h"
+#include "lz4.h"
 #include "mm_alloc.h"
 #include "support.h"
 
 // Even relocate if the memory region the binary is linked to is free.
 static int const always_relocate = 0;
 
+// Only a position independent binary can be relocated. The allocator may be
+// present without that for decompressing the binary.
+#ifdef BOOTSTRAP64_PIE
+static int const reloc_allowed = 1;
+#else
+static int const reloc_allowed = 0;
+#endif
+
+#ifndef SHT_RELR
+#define SHT_RELR 19
+#endif
+
 /**
  * Function to relocate a value based on an ELF relocation entry.
  *
@@ -42,6 +56,42 @@ static void relocate_rela_entry(Elf64_Rela* rel, Elf64_Sxword offset)
     }
 }
 
+/**
+ * Apply a table of packed relative relocations (RELR).
+ *
+ * An even entry is the address of a relocation target and sets the current
+ * position behind it. An odd entry is a bitmap, bit n marks a target at
+ * position + (n - 1) words, afterwards the position advances by 63 words.
+ *
+ * \param relr    The RELR table from the .relr.dyn section
+ * \param size    Size of the table in bytes
+ * \param offset  The signed offset of by how much to relocate the targets
+ */
+static void relocate_relr(Elf64_Xword const *relr, Elf64_Xword size,
+                          Elf64_Sxword offset)
+{
+  Elf64_Addr *where = NULL;
+  for (Elf64_Xword const *e = relr; e < relr + size / sizeof(*e); ++e)
+    {
+      if (!(*e & 1))
+        {
+          where = (Elf64_Addr *)(Elf32_Addr)(*e + offset);
+          *where++ += offset;
+          continue;
+        }
+
+      if (!where)
+        panic("RELR bitmap without preceding address");
+
+      Elf64_Xword bits = *e >> 1;
+      for (Elf64_Addr *w = where; bits; bits >>= 1, ++w)
+        if (bits & 1)
+          *w += offset;
+
+      where += 63;
+    }
+}
+
 /**
  * Check if the specified range fits into the address range 0..4GiB.
  *
@@ -136,7 +186,7 @@ load_elf(void const *elf)
   // Only relocate when memory is not free anyways
   if (always_relocate || need_reloc)
     {
-      if (!mm_alloc_alloc)
+      if (!reloc_allowed || !mm_alloc_alloc)
         panic("Memory already used and relocation not enabled!");
 
       // Round down to max alignment to ensure all sections are correctly aligned
@@ -178,6 +228,10 @@ load_elf(void const *elf)
                   relocate_rela_entry(rel, reloc);
                 break;
               }
+            case SHT_RELR:
+              relocate_relr((Elf64_Xword const *)(_elf + sh->sh_offset),
+                            sh->sh_size, reloc);
+              break;
             case SHT_REL:
               panic("Unsupported relocation type SHT_REL");
             }
@@ -186,3 +240,90 @@ load_elf(void const *elf)
 
   return eh->e_entry + reloc;
 }
+
+/**
+ * Load an LZ4-compressed ELF binary into memory.
+ *
+ * The binary is decoded into a buffer directly behind its load address range
+ * if that memory is free, otherwise into memory from the allocator, and then
+ * loaded from there.
+ *
+ * \param lz4      Start of the LZ4 legacy frame.
+ * \param size     Size of the frame.
+ * \param mem_end  End of the usable memory.
+ */
+l4_uint32_t
+load_elf_lz4(void const *lz4, unsigned long size, l4_uint64_t mem_end)
+{
+  static Elf64_Ehdr hdr_buf[1024 / sizeof(Elf64_Ehdr)];
+  unsigned long n = lz4_decode_legacy(lz4, size, hdr_buf, sizeof(hdr_buf));
+
+  char const *hdr = (char const *)hdr_buf;
+  Elf64_Ehdr const *eh = hdr_buf;
+  if (n < sizeof(*eh))
+    panic("Invalid compressed ELF file: too short");
+  sanity_elf(eh);
+
+  if (eh->e_phoff + eh->e_phnum * sizeof(Elf64_Phdr) > n)
+    panic("Invalid compressed ELF file: program headers not at the start");
+
+  // The section header table is placed at the end of the file, so the size
+  // of the binary is known without decoding it completely.
+  Elf64_Phdr const *ph = (Elf64_Phdr const *)(hdr + eh->e_phoff);
+  Elf64_Addr min_addr = ~0ULL;
+  Elf64_Addr max_addr = 0ULL; // the address *after* the last byte
+  Elf64_Xword max_align = L4_PAGESIZE;
+  Elf64_Off elf_end = eh->e_shoff + eh->e_shnum * sizeof(Elf64_Shdr);
+  for (unsigned i = 0; i < eh->e_phnum; ++i)
+    {
+      if (elf_end < ph[i].p_offset + ph[i].p_filesz)
+        elf_end = ph[i].p_offset + ph[i].p_filesz;
+
+      if (ph[i].p_type != PT_LOAD)
+        continue;
+
+      if (max_align < ph[i].p_align)
+        max_align = ph[i].p_align;
+
+      if (min_addr > ph[i].p_paddr)
+        min_addr = ph[i].p_paddr;
+
+      if (max_addr < ph[i].p_paddr + ph[i].p_memsz)
+        max_addr = ph[i].p_paddr + ph[i].p_memsz;
+    }
+
+  if (elf_end + max_align > (1ULL << 32))
+    panic("Invalid compressed ELF file: too large");
+
+  unsigned long elf_size = elf_end;
+
+  // Keep the allocator aligned for a later relocation of the binary
+  unsigned long alloc_size = (elf_size + max_align - 1) & ~(max_align - 1);
+
+  // Prefer the RAM behind the binary, keeping the free memory contiguous
+  Elf64_Addr buf = (max_addr + L4_PAGESIZE - 1) & ~(Elf64_Addr)(L4_PAGESIZE - 1);
+  if (!usable_range(buf, elf_size) || buf + elf_size > mem_end
+      || !mm_alloc_is_ram || !mm_alloc_is_ram(buf, elf_size))
+    {
+      if (!mm_alloc_alloc)
+        panic("No memory to decompress the ELF binary!");
+
+      // The allocator does not know about the load address range of the
+      // binary, a non-relocatable binary must not be overwritten.
+      do
+        buf = (Elf32_Addr)mm_alloc_alloc(alloc_size);
+      while (buf && buf < max_addr && buf + elf_size > min_addr);
+
+      if (!buf)
+        panic("Unable to allocate memory for decompression!");
+    }
+
+  printf("  Decompressing %lu to %lu bytes at %llx\n", size, elf_size, buf);
+  if (lz4_decode_legacy(lz4, size, (void *)(Elf32_Addr)buf, elf_size)
+      != elf_size)
+    panic("Invalid compressed ELF file: truncated");
+
+  // The relocation of the binary must not overwrite its source
+  reservation_add(buf, elf_size);
+  return load_elf((void const *)(Elf32_Addr)buf);
+}
@@ -13,5 +13,7 @@
 
 void reserve_elf(void const *elf);
 l4_uint32_t load_elf(void const *elf);
+l4_uint32_t load_elf_lz4(void const *lz4, unsigned long size,
+                         l4_uint64_t mem_end);
 
 #endif
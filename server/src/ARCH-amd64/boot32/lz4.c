@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <string.h>
+
+#include "lz4.h"
+#include "support.h"
+
+static unsigned long
+get_le32(unsigned char const *p)
+{ return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned long)p[3] << 24); }
+
+int
+lz4_is_legacy(void const *src, unsigned long size)
+{ return size >= 4 && get_le32(src) == Lz4_legacy_magic; }
+
+/**
+ * Read the extension bytes of a literal or match length.
+ */
+static unsigned long
+get_length(unsigned char const **s, unsigned char const *end,
+           unsigned long len)
+{
+  if (len != 15)
+    return len;
+
+  unsigned char b;
+  do
+    {
+      if (*s >= end)
+        panic("LZ4: truncated length");
+      b = *(*s)++;
+      len += b;
+    }
+  while (b == 255);
+
+  return len;
+}
+
+/**
+ * Decode one LZ4 block.
+ *
+ * \param out  Number of bytes decoded before this block. Matches must not
+ *             reach back further, blocks of the legacy format are
+ *             independent.
+ */
+static unsigned long
+decode_block(unsigned char const *s, unsigned char const *end,
+             unsigned char *dst, unsigned long out, unsigned long dst_size)
+{
+  unsigned long const block_start = out;
+
+  while (s < end && out < dst_size)
+    {
+      unsigned char token = *s++;
+
+      unsigned long lit = get_length(&s, end, token >> 4);
+      if (lit > (unsigned long)(end - s))
+        panic("LZ4: truncated literals");
+
+      if (dst)
+        memcpy(dst + out, s,
+               lit < dst_size - out ? lit : dst_size - out);
+      s += lit;
+      out += lit;
+
+      // The last sequence of a block consists of literals only
+      if (s >= end || out >= dst_size)
+        break;
+
+      if (end - s < 2)
+        panic("LZ4: truncated match offset");
+      unsigned long off = s[0] | (s[1] << 8);
+      s += 2;
+
+      unsigned long len = get_length(&s, end, token & 15) + 4;
+      if (off == 0 || off > out - block_start)
+        panic("LZ4: invalid match offset");
+
+      if (len > dst_size - out)
+        len = dst_size - out;
+
+      if (dst)
+        {
+          unsigned char *d = dst + out;
+          if (off >= len)
+            memcpy(d, d - off, len);
+          else
+            // Overlapping match repeating the last `off` bytes
+            for (unsigned long i = 0; i < len; ++i)
+              d[i] = d[i - off];
+        }
+      out += len;
+    }
+
+  return out;
+}
+
+unsigned long
+lz4_decode_legacy(void const *src, unsigned long size,
+                  void *dst, unsigned long dst_size)
+{
+  unsigned char const *s = (unsigned char const *)src;
+  unsigned char const *end = s + size;
+  unsigned long out = 0;
+
+  if (!lz4_is_legacy(src, size))
+    panic("LZ4: no legacy frame");
+
+  if (!dst)
+    dst_size = ~0UL;
+
+  s += 4;
+  while (end - s >= 4 && out < dst_size)
+    {
+      unsigned long bsize = get_le32(s);
+      s += 4;
+
+      // Concatenated frames
+      if (bsize == Lz4_legacy_magic)
+        continue;
+
+      if (bsize > (unsigned long)(end - s))
+        panic("LZ4: truncated block");
+
+      out = decode_block(s, s + bsize, (unsigned char *)dst, out, dst_size);
+      s += bsize;
+    }
+
+  return out;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+enum { Lz4_legacy_magic = 0x184c2102 };
+
+/**
+ * Check whether a buffer starts with an LZ4 legacy frame as written by
+ * `lz4 -l`.
+ */
+int lz4_is_legacy(void const *src, unsigned long size);
+
+/**
+ * Decode an LZ4 legacy frame.
+ *
+ * Decoding stops after `dst_size` bytes, so a prefix of the data can be
+ * decoded into a small buffer.
+ *
+ * \param src       Start of the frame.
+ * \param size      Size of the frame.
+ * \param dst       Destination buffer, NULL to only determine the size of
+ *                  the decoded data.
+ * \param dst_size  Size of the destination buffer.
+ *
+ * \returns Number of decoded bytes.
+ */
+unsigned long lz4_decode_legacy(void const *src, unsigned long size,
+                                void *dst, unsigned long dst_size);
@@ -140,3 +140,20 @@ mm_alloc_alloc(unsigned long size)
   // Uninitialized or no more available regions
   return NULL;
 }
+
+int
+mm_alloc_is_ram(unsigned long long start, unsigned long long size)
+{
+  l4util_mb_info_t *mbi = mm_alloc.mbi;
+  if (!mbi || !(mbi->flags & L4UTIL_MB_MEM_MAP))
+    return 0;
+
+  unsigned long map_end = mbi->mmap_addr + mbi->mmap_length;
+  for (l4util_mb_addr_range_t *r = l4util_mb_first_mmap_entry(mbi);
+       (unsigned long)r < map_end; r = l4util_mb_next_mmap_entry(r))
+    if (r->type == MB_ART_MEMORY
+        && start >= r->addr && start + size <= r->addr + r->size)
+      return 1;
+
+  return 0;
+}
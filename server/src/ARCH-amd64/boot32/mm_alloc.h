@@ -35,3 +35,16 @@ void mm_alloc_init(l4util_mb_info_t *mbi) __attribute__((weak));
  *               initialized.
  */
 void *mm_alloc_alloc(unsigned long size) __attribute__((weak));
+
+/**
+ * Check if a range lies completely in RAM according to the multiboot memory
+ * map.
+ *
+ * \param start  Start of the range.
+ * \param size   Size of the range.
+ *
+ * \retval 1  The range is inside a single MB_ART_MEMORY entry.
+ * \retval 0  Otherwise or if the allocator was not initialized.
+ */
+int mm_alloc_is_ram(unsigned long long start, unsigned long long size)
+  __attribute__((weak));
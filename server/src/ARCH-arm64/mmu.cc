@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <l4/cxx/minmax>
+#include <l4/sys/consts.h>
+
+#include "arch/arm/mem.h"
+#include "mmu.h"
+
+extern "C" {
+/// Register values for mp_worker_psci_entry, `ttbr` is 0 if the MMU is off
+struct Mmu_worker_regs
+{
+  l4_uint64_t mair;
+  l4_uint64_t tcr;
+  l4_uint64_t ttbr;
+  l4_uint64_t sctlr;
+};
+
+Mmu_worker_regs mp_worker_mmu;
+}
+
+bool mmu_prepare_workers()
+{
+  // The workers read this with MMU and caches disabled
+  Cache::Data::clean(reinterpret_cast<unsigned long>(&mp_worker_mmu),
+                     sizeof(mp_worker_mmu));
+  return mp_worker_mmu.ttbr || !Cache::Data::enabled();
+}
+
+#if __ARM_ARCH_PROFILE == 'R'
+
+// Armv8-R has an MPU instead of an MMU.
+bool mmu_enable_identity(Region_list const &, Region_list const &,
+                         Region const &)
+{ return false; }
+
+void mmu_disable_identity()
+{}
+
+#else
+
+extern "C" void armv8_disable_mmu(void);
+
+namespace {
+
+enum : l4_uint64_t
+{
+  Desc_table   = 3,            ///< Next level table, levels 0 to 2
+  Desc_block   = 1,            ///< Block, levels 1 and 2
+  Desc_page    = 3,            ///< Page, level 3
+  Attr_device  = 0 << 2,       ///< MAIR index 0
+  Attr_normal  = 1 << 2,       ///< MAIR index 1
+  Ap_res1      = 1 << 6,       ///< AP[1] is RES1 in the EL2 regime
+  Sh_inner     = 3 << 8,
+  Af           = 1 << 10,
+  Xn           = 3ULL << 53,   ///< PXN and UXN, XN in the EL2 regime
+
+  /// Index 0: Device-nGnRnE, index 1: Normal write-back read/write-allocate
+  Mair         = 0xffUL << 8,
+
+  Tcr_t0sz_48  = 16,
+  Tcr_wbwa     = (1 << 8) | (1 << 10),  ///< IRGN0 and ORGN0
+  Tcr_sh_inner = 3 << 12,
+  Tcr_el2_res1 = (1UL << 31) | (1UL << 23),
+  Tcr_el1_epd1 = 1UL << 23,
+
+  Sctlr_m      = 1 << 0,
+  Sctlr_c      = 1 << 2,
+  Sctlr_i      = 1 << 12,
+  Sctlr_wxn    = 1 << 19,
+
+  Hcr_e2h      = 1UL << 34,
+};
+
+enum
+{
+  Pt_entries   = 512,
+  Pt_pages     = 32,
+  Level0_shift = 39,
+  Max_normal   = 64,
+};
+
+l4_uint64_t pt_pool[Pt_pages][Pt_entries] __attribute__((aligned(L4_PAGESIZE)));
+unsigned pt_used;
+bool enabled;
+
+struct Range
+{
+  l4_uint64_t start;
+  l4_uint64_t end;    ///< inclusive
+};
+
+/// Disjoint ranges mapped as Normal memory
+Range normal[Max_normal];
+unsigned num_normal;
+
+enum Kind { Device, Normal, Mixed };
+
+Kind classify(l4_uint64_t start, l4_uint64_t size)
+{
+  l4_uint64_t end = start + size - 1;
+  l4_uint64_t covered = 0;
+  for (unsigned i = 0; i < num_normal; ++i)
+    {
+      l4_uint64_t s = cxx::max(start, normal[i].start);
+      l4_uint64_t e = cxx::min(end, normal[i].end);
+      if (s <= e)
+        covered += e - s + 1;
+    }
+
+  if (!covered)
+    return Device;
+  return covered == size ? Normal : Mixed;
+}
+
+/**
+ * Remove [start, end] from the Normal ranges.
+ *
+ * \retval false  No free slot to split a range.
+ */
+bool carve_out(l4_uint64_t start, l4_uint64_t end)
+{
+  for (unsigned i = 0; i < num_normal; ++i)
+    {
+      Range &n = normal[i];
+      if (start > n.end || end < n.start)
+        continue;
+
+      if (start > n.start && end < n.end)
+        {
+          if (num_normal == Max_normal)
+            return false;
+          normal[num_normal++] = Range{end + 1, n.end};
+          n.end = start - 1;
+        }
+      else if (start > n.start)
+        n.end = start - 1;
+      else if (end < n.end)
+        n.start = end + 1;
+      else
+        {
+          normal[i--] = normal[--num_normal];
+          continue;
+        }
+    }
+
+  return true;
+}
+
+l4_uint64_t *alloc_table()
+{
+  if (pt_used == Pt_pages)
+    return nullptr;
+
+  l4_uint64_t *t = pt_pool[pt_used++];
+  memset(t, 0, L4_PAGESIZE);
+  return t;
+}
+
+/**
+ * Fill a translation table with the identity mapping for [base, limit).
+ *
+ * Uses the largest possible blocks and only descends where Normal and Device
+ * memory share a block.
+ */
+bool fill_table(l4_uint64_t *table, unsigned level, l4_uint64_t base,
+                l4_uint64_t limit, l4_uint64_t ap)
+{
+  unsigned shift = Level0_shift - 9 * level;
+  l4_uint64_t size = 1ULL << shift;
+
+  for (unsigned i = 0; i < Pt_entries; ++i)
+    {
+      l4_uint64_t addr = base + i * size;
+      if (addr >= limit)
+        break;
+
+      Kind k = classify(addr, size);
+      // RAM not ending at a page boundary
+      if (level == 3 && k == Mixed)
+        k = Normal;
+
+      // There are no level 0 blocks with 4K granules
+      if (level == 0 || k == Mixed)
+        {
+          l4_uint64_t *next = alloc_table();
+          if (!next || !fill_table(next, level + 1, addr, limit, ap))
+            return false;
+
+          table[i] = reinterpret_cast<l4_addr_t>(next) | Desc_table;
+          continue;
+        }
+
+      table[i] = addr | (level == 3 ? Desc_page : Desc_block) | ap | Af
+                 | (k == Normal ? Attr_normal | Sh_inner : Attr_device | Xn);
+    }
+
+  return true;
+}
+
+}
+
+bool mmu_enable_identity(Region_list const &ram, Region_list const &regions,
+                         Region const &image)
+{
+  unsigned el = Arm::Internal::current_el();
+  if (el != 1 && el != 2)
+    return false;
+
+  if (Arm::Internal::sctlr() & (Sctlr_m | Sctlr_c))
+    return false;
+
+  if (el == 2)
+    {
+      l4_uint64_t hcr;
+      asm ("mrs %0, HCR_EL2" : "=r" (hcr));
+      if (hcr & Hcr_e2h)
+        return false;
+    }
+
+  num_normal = 0;
+  l4_uint64_t top = 0;
+  for (Region const &r : ram)
+    {
+      if (num_normal == Max_normal - 1)
+        {
+          printf("  Too many RAM regions, running with MMU disabled.\n");
+          return false;
+        }
+      normal[num_normal++] = Range{r.begin(), r.end()};
+      top = cxx::max<l4_uint64_t>(top, r.end());
+    }
+
+  // Firmware reservations might be secure memory, keep them Device memory so
+  // that they are never accessed speculatively.
+  for (Region const &r : regions)
+    if (r.type() == Region::Arch && !carve_out(r.begin(), r.end()))
+      {
+        printf("  Too many reserved regions, running with MMU disabled.\n");
+        return false;
+      }
+
+  if (num_normal == Max_normal)
+    {
+      printf("  Too many reserved regions, running with MMU disabled.\n");
+      return false;
+    }
+
+  // The image might not be in RAM but must not be mapped as Device memory
+  if (!ram.contains(image))
+    {
+      normal[num_normal++] = Range{image.begin(), image.end()};
+      top = cxx::max<l4_uint64_t>(top, image.end());
+    }
+
+  // Everything up to the end of RAM, at least the first 512 GiB
+  l4_uint64_t limit = ((top >> Level0_shift) + 1) << Level0_shift;
+
+  pt_used = 0;
+  l4_uint64_t *root = alloc_table();
+  if (!fill_table(root, 0, 0, limit, el == 2 ? Ap_res1 : 0))
+    {
+      printf("  Not enough page tables, running with MMU disabled.\n");
+      return false;
+    }
+
+  l4_uint64_t pa_range;
+  asm ("mrs %0, ID_AA64MMFR0_EL1" : "=r" (pa_range));
+  pa_range = cxx::min<l4_uint64_t>(pa_range & 0xf, 5); // at most 48 bits
+
+  l4_uint64_t tcr = Tcr_t0sz_48 | Tcr_wbwa | Tcr_sh_inner;
+  if (el == 2)
+    {
+      tcr |= Tcr_el2_res1 | (pa_range << 16);
+      asm volatile ("msr MAIR_EL2, %0  \n"
+                    "msr TCR_EL2, %1   \n"
+                    "msr TTBR0_EL2, %2 \n"
+                    "isb               \n"
+                    "tlbi alle2        \n"
+                    "dsb sy            \n"
+                    "isb               \n"
+                    : : "r" (Mair), "r" (tcr), "r" (root) : "memory");
+    }
+  else
+    {
+      tcr |= Tcr_el1_epd1 | (pa_range << 32);
+      asm volatile ("msr MAIR_EL1, %0  \n"
+                    "msr TCR_EL1, %1   \n"
+                    "msr TTBR0_EL1, %2 \n"
+                    "isb               \n"
+                    "tlbi vmalle1      \n"
+                    "dsb sy            \n"
+                    "isb               \n"
+                    : : "r" (Mair), "r" (tcr), "r" (root) : "memory");
+    }
+
+  // Drop whatever the firmware left in the caches. Invalidate only, the
+  // memory contents written with caches disabled are the valid ones.
+  Arm_v7plus::set_way_full_loop(Arm::Internal::dc_isw,
+                                Arm::Internal::get_clidr,
+                                Arm::Internal::get_ccsidr,
+                                Arm_v7plus::set_way_dcache_noinfo_op());
+  Cache::Insn::inv();
+
+  l4_uint64_t sctlr = (Arm::Internal::sctlr() | Sctlr_m | Sctlr_c | Sctlr_i)
+                      & ~Sctlr_wxn;
+  Arm::Internal::sctlr(sctlr);
+  Barrier::isb();
+
+  mp_worker_mmu = Mmu_worker_regs{Mair, tcr, reinterpret_cast<l4_addr_t>(root),
+                                  sctlr};
+  enabled = true;
+  printf("  MMU and caches enabled (%u page tables).\n", pt_used);
+  return true;
+}
+
+void mmu_disable_identity()
+{
+  if (!enabled)
+    return;
+
+  // Cleans and invalidates the data cache before turning MMU and caches off
+  // without touching memory in between.
+  armv8_disable_mmu();
+
+  if (Arm::Internal::current_el() == 2)
+    asm volatile ("tlbi alle2; dsb sy; isb" : : : "memory");
+  else
+    asm volatile ("tlbi vmalle1; dsb sy; isb" : : : "memory");
+
+  mp_worker_mmu.ttbr = 0;
+  enabled = false;
+}
+
+#endif
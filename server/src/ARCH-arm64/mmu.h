@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include "region.h"
+
+/**
+ * Enable MMU and caches with an identity mapping.
+ *
+ * Copying, decompressing and loading modules with caches disabled is several
+ * times slower. RAM and the bootstrap image are mapped as cacheable Normal
+ * memory, all other physical addresses as Device memory. Firmware reservations
+ * inside RAM (e.g. `/reserved-memory` nodes and `/memreserve/` entries) stay
+ * Device memory as they may be secure carve-outs that must not even be
+ * accessed speculatively. Nothing is done if the MMU is already enabled, e.g.
+ * by UEFI.
+ *
+ * \param ram      Conventional memory.
+ * \param regions  Reserved regions, those of type Region::Arch are not mapped
+ *                 as Normal memory.
+ * \param image    The bootstrap image.
+ *
+ * \retval true   MMU and caches are enabled.
+ * \retval false  MMU and caches were left alone.
+ */
+bool mmu_enable_identity(Region_list const &ram, Region_list const &regions,
+                         Region const &image);
+
+/**
+ * Clean the data cache and disable MMU and caches again.
+ *
+ * Only has an effect after mmu_enable_identity() succeeded.
+ */
+void mmu_disable_identity();
+
+/**
+ * Prepare starting secondary CPUs as workers.
+ *
+ * Workers entering through mp_worker_psci_entry enable the MMU with the page
+ * tables of the boot CPU if mmu_enable_identity() succeeded, so that they see
+ * the same memory contents as the boot CPU.
+ *
+ * \retval true   Workers run in the same cache state as the boot CPU.
+ * \retval false  The caches were enabled by someone else, e.g. UEFI, and
+ *                workers must not be used.
+ */
+bool mmu_prepare_workers();
@@ -5,20 +5,29 @@
  * License: see LICENSE.spdx (in this directory or the directories above)
  */
 
+#include "bulk_copy.h"
 #include "dt.h"
 #include "isa_parser.h"
 #include "platform_riscv.h"
 #include "startup.h"
 #include "support.h"
+#include "timestamp.h"
 
 #include <strings.h>
 
+extern volatile unsigned long mp_launch_worker;
+
 #ifdef CONFIG_DRIVERS_FRST_UART_DRV_SBI
 #include <l4/drivers/uart_sbi.h>
 #endif
 
 void Platform_riscv_base::init()
 {
+#ifdef CONFIG_BOOTSTRAP_RISCV_CBO_ZERO
+  // cbo.zero traps in S-mode unless the firmware has set menvcfg.CBZE
+  bulk_zero_set_cbo_block_size(get_cbo_zero_block_size());
+#endif
+  timestamp_set_freq(get_timebase_frequency());
 }
 
 l4_addr_t Platform_riscv_base::get_fdt_addr() const
@@ -74,6 +83,39 @@ void Platform_riscv_base::boot_kernel(unsigned long entry)
   Platform_base::boot_kernel(entry);
 }
 
+unsigned Platform_riscv_base::start_workers(unsigned max_slots)
+{
+  // All harts but the boot hart wait in crt0 and call mp_worker_main() with
+  // their hart ID as slot while mp_launch_worker is set. Harts that were not
+  // started by the firmware (SBI HSM) never show up.
+  Dt::Node cpus = dt.node_by_path("/cpus");
+  if (!cpus.is_valid())
+    return 0;
+
+  l4_umword_t self;
+  asm ("mv %0, tp" : "=r" (self));
+
+  unsigned slots = 0;
+  cpus.for_each_subnode([&](Dt::Node cpu)
+    {
+      l4_uint32_t hartid;
+      if (riscv_cpu_isa(cpu) && riscv_cpu_hartid(cpu, hartid)
+          && hartid != self && hartid < max_slots)
+        slots |= 1U << hartid;
+      return Dt::Continue;
+    });
+
+  asm volatile ("fence" : : : "memory");
+  mp_launch_worker = 1;
+  return slots;
+}
+
+void Platform_riscv_base::stop_workers()
+{
+  mp_launch_worker = 0;
+  asm volatile ("fence" : : : "memory");
+}
+
 void Platform_riscv_base::setup_kuart_from_dt(char const *compatible)
 {
   // Use UART specified via /chosen/stdout-path if present and compatible
@@ -271,6 +313,51 @@ Platform_riscv_base::parse_harts(l4_kip_platform_info_arch &arch_info) const
   return true;
 }
 
+/**
+ * Get the Zicboz block size common to all harts.
+ *
+ * \return Block size in bytes, 0 if not all harts implement Zicboz.
+ */
+l4_uint32_t Platform_riscv_base::get_cbo_zero_block_size() const
+{
+  Dt::Node cpus = dt.node_by_path("/cpus");
+  if (!cpus.is_valid())
+    return 0;
+
+  l4_uint32_t block_size = 0;
+  bool usable = true;
+  cpus.for_each_subnode([&](Dt::Node cpu)
+    {
+      char const *isa = riscv_cpu_isa(cpu);
+      if (!isa)
+        return Dt::Continue;
+
+      bool has_zicboz = cpu.stringlist_contains("riscv,isa-extensions", "zicboz");
+      if (!has_zicboz && (starts_with(isa, "rv32") || starts_with(isa, "rv64")))
+        {
+          Isa_parser isa_parser(isa + 4);
+          while (!has_zicboz && isa_parser.next_ext())
+            {
+              cxx::String const ext = isa_parser.ext();
+              has_zicboz = ext.len() == 6 && !strncasecmp(ext.start(), "zicboz", 6);
+            }
+        }
+
+      l4_uint32_t sz;
+      if (!has_zicboz || !cpu.get_prop_u32("riscv,cboz-block-size", sz)
+          || (block_size && block_size != sz))
+        {
+          usable = false;
+          return Dt::Break;
+        }
+
+      block_size = sz;
+      return Dt::Continue;
+    });
+
+  return usable ? block_size : 0;
+}
+
 l4_uint32_t Platform_riscv_base::get_timebase_frequency() const
 {
   l4_uint32_t timebase_frequency = 0;
@@ -18,6 +18,8 @@ public:
   void init_dt() override;
   void setup_kernel_config(l4_kernel_info_t*kip) override;
   void boot_kernel(unsigned long entry) override;
+  unsigned start_workers(unsigned max_slots) override;
+  void stop_workers() override;
 
 protected:
   static int parse_plic_irq(Dt::Node node);
@@ -31,5 +33,6 @@ private:
   bool parse_isa_ext(l4_kip_platform_info_arch &arch_info) const;
   bool parse_harts(l4_kip_platform_info_arch &arch_info) const;
   l4_uint32_t get_timebase_frequency() const;
+  l4_uint32_t get_cbo_zero_block_size() const;
   bool parse_interrupt_target_contexts(l4_kip_platform_info_arch &arch_info) const;
 };
@@ -104,9 +104,11 @@ Sdt::init(void *root)
   if (Print_info)
     rsdp->print_info();
 
-  if (rsdp->rev && rsdp->xsdt_phys)
+  // On 32-bit platforms the XSDT might not be accessible
+  if (rsdp->rev && rsdp->xsdt_phys
+      && rsdp->xsdt_phys == (unsigned long)rsdp->xsdt_phys)
     {
-      auto *x = (const Xsdt *)rsdp->xsdt_phys;
+      auto *x = (const Xsdt *)(unsigned long)rsdp->xsdt_phys;
       if (!x->checksum_ok())
         printf("ACPI: Checksum mismatch in XSDT\n");
       else
@@ -172,13 +174,35 @@ Table_head const *
 Sdt::entry(unsigned i) const
 {
   if (_xsdt)
-    return (Table_head const *)_xsdt->ptrs[i];
+    return _xsdt->ptrs[i] == (unsigned long)_xsdt->ptrs[i]
+           ? (Table_head const *)(unsigned long)_xsdt->ptrs[i] : nullptr;
   else if (_rsdt)
     return (Table_head const *)(unsigned long)_rsdt->ptrs[i];
   else
     return nullptr;
 }
 
+Table_head const *
+Sdt::dsdt() const
+{
+  auto const *fadt = find<Fadt const *>("FACP");
+  if (!fadt)
+    return nullptr;
+
+  // X_DSDT is only present since ACPI 2.0
+  l4_uint64_t addr = fadt->dsdt;
+  auto const *x_dsdt_end = reinterpret_cast<char const *>(&fadt->x_dsdt + 1);
+  if (fadt->len >= x_dsdt_end - reinterpret_cast<char const *>(fadt)
+      && fadt->x_dsdt)
+    addr = fadt->x_dsdt;
+
+  if (!addr || addr != (unsigned long)addr)
+    return nullptr;
+
+  auto const *t = reinterpret_cast<Table_head const *>((unsigned long)addr);
+  return check_signature(t->signature, "DSDT") && t->checksum_ok() ? t : nullptr;
+}
+
 void
 Sdt::print_summary() const
 {
@@ -187,4 +211,88 @@ Sdt::print_summary() const
       entry(i)->print_info();
 }
 
+namespace {
+
+enum : l4_uint8_t
+{
+  Aml_zero       = 0x00,
+  Aml_one        = 0x01,
+  Aml_name       = 0x08,
+  Aml_byte       = 0x0a,
+  Aml_word       = 0x0b,
+  Aml_dword      = 0x0c,
+
+  Res_dword_addr = 0x87,
+  Res_word_addr  = 0x88,
+  Res_qword_addr = 0x8a,
+  Res_bus_range  = 2,
+};
+
+l4_uint64_t
+read_le(l4_uint8_t const *p, unsigned bytes)
+{
+  l4_uint64_t v = 0;
+  for (unsigned i = bytes; i > 0; --i)
+    v = (v << 8) | p[i - 1];
+  return v;
+}
+
+void
+mark_bus(l4_uint32_t *buses, l4_uint64_t bus)
+{
+  if (bus < 256)
+    buses[bus / 32] |= 1U << (bus % 32);
+}
+
+}
+
+void
+pci_root_buses(Table_head const *aml, l4_uint32_t buses[8])
+{
+  auto const *start = reinterpret_cast<l4_uint8_t const *>(aml);
+  auto const *end = start + aml->len;
+
+  for (auto const *p = start + sizeof(Table_head); p + 5 < end; ++p)
+    {
+      // Name (_BBN, <constant>)
+      if (check_signature(reinterpret_cast<char const *>(p + 1), "_BBN"))
+        {
+          // Method (_BBN) or a reference cannot be evaluated
+          l4_uint8_t const *v = p + 5;
+          if (p[0] != Aml_name)
+            continue;
+          if (v[0] == Aml_zero || v[0] == Aml_one)
+            mark_bus(buses, v[0]);
+          else if (v[0] == Aml_byte && v + 1 < end)
+            mark_bus(buses, v[1]);
+          else if (v[0] == Aml_word && v + 2 < end)
+            mark_bus(buses, read_le(v + 1, 2));
+          else if (v[0] == Aml_dword && v + 4 < end)
+            mark_bus(buses, read_le(v + 1, 4));
+          continue;
+        }
+
+      // Bus number range in a WORD, DWORD or QWORD address space descriptor
+      unsigned size;
+      switch (p[0])
+        {
+        case Res_word_addr:  size = 2; break;
+        case Res_dword_addr: size = 4; break;
+        case Res_qword_addr: size = 8; break;
+        default: continue;
+        }
+
+      // The descriptor might be followed by an optional resource source
+      unsigned len = 3 + 5 * size;
+      if (p + 3 + len > end || read_le(p + 1, 2) < len
+          || p[3] != Res_bus_range)
+        continue;
+
+      l4_uint64_t min = read_le(p + 6 + size, size);
+      l4_uint64_t max = read_le(p + 6 + 2 * size, size);
+      if (min <= max)
+        mark_bus(buses, min);
+    }
+}
+
 }
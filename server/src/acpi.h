@@ -62,6 +62,19 @@ public:
     return reinterpret_cast<T>(find_head(sig));
   }
 
+  /// Call `cb` for each valid table with the given signature.
+  template<typename CB>
+  void for_each(char const *sig, CB &&cb) const
+  {
+    for (unsigned i = 0; i < entries(); ++i)
+      if (Table_head const *t = entry(i))
+        if (check_signature(t->signature, sig) && t->checksum_ok())
+          cb(t);
+  }
+
+  /// The DSDT referenced by the FADT, nullptr if none.
+  Table_head const *dsdt() const;
+
 private:
   Table_head const *find_head(char const *sig) const;
   unsigned entries() const;
@@ -133,6 +146,39 @@ struct Fadt : public Table_head
     l4_uint64_t                  hypervisor_id;
 } __attribute__((packed));
 
+/**
+ * Find the PCI root buses declared in a DSDT or SSDT.
+ *
+ * Without an AML interpreter, the table is searched for `_BBN` objects with a
+ * constant value and for bus number ranges in resource templates, i.e. the
+ * `_CRS` of host bridges. The first bus of each such range is marked in
+ * `buses`. Root buses only known by evaluating AML are missed.
+ *
+ * \param      aml    DSDT or SSDT.
+ * \param[out] buses  Bitmap of 256 buses.
+ */
+void pci_root_buses(Table_head const *aml, l4_uint32_t buses[8]);
+
+struct Mcfg : public Table_head
+{
+  l4_uint64_t reserved;
+
+  /// Memory-mapped configuration space of a PCI segment
+  struct Entry
+  {
+    l4_uint64_t base;     ///< Address of bus 0, even if not decoded
+    l4_uint16_t segment;
+    l4_uint8_t  start_bus;
+    l4_uint8_t  end_bus;
+    l4_uint32_t reserved;
+  } __attribute__((packed));
+
+  Entry entries[0];
+
+  unsigned num_entries() const
+  { return (len - sizeof(Mcfg)) / sizeof(Entry); }
+} __attribute__((packed));
+
 struct Spcr : public Table_head
 {
   enum
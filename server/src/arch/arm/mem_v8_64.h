@@ -24,6 +24,11 @@ public:
     asm volatile("dc csw, %0" : : "r" (v) : "memory");
   }
 
+  static inline void dc_isw(unsigned long v)
+  {
+    asm volatile("dc isw, %0" : : "r" (v) : "memory");
+  }
+
   static inline void ic_iallu()
   {
     asm volatile("ic iallu" : : : "memory");
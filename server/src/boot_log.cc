@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <l4/cxx/minmax>
+#include <l4/sys/consts.h>
+
+#include "boot_log.h"
+#include "memory.h"
+#include "region.h"
+#include "support.h"
+
+namespace {
+
+struct Log_module : Internal_module_base
+{
+  Log_module() : Internal_module_base(".bootlog") {}
+
+  void set_region(l4util_l4mod_mod *m) const override
+  {
+    m->mod_start = addr;
+    m->mod_end   = addr + size;
+  }
+
+  l4_addr_t addr = 0;
+  unsigned long size = 0;
+};
+
+Log_module log_module;
+
+char buffer[Boot_log::Buffer_size];
+unsigned long len;      ///< Bytes in the buffer
+unsigned long flushed;  ///< Bytes of the buffer already written to the UART
+bool enabled;
+bool quiet;
+
+}
+
+void
+Boot_log::enable(bool q)
+{
+  quiet = q;
+  enabled = true;
+}
+
+bool
+Boot_log::write(char const *s, unsigned long n)
+{
+  if (!enabled)
+    return false;
+
+  while (n)
+    {
+      if (len == Buffer_size)
+        {
+          // Only the most recent output ends up in the module
+          flush();
+          len = flushed = 0;
+        }
+
+      unsigned long c = cxx::min<unsigned long>(n, Buffer_size - len);
+      memcpy(buffer + len, s, c);
+      len += c;
+      s += c;
+      n -= c;
+    }
+
+  return true;
+}
+
+void
+Boot_log::flush()
+{
+  if (!quiet && flushed < len)
+    console_write(buffer + flushed, len - flushed);
+  flushed = len;
+}
+
+void
+Boot_log::error()
+{
+  if (!enabled)
+    return;
+
+  // Also in quiet mode: the pending output most likely explains the error
+  if (flushed < len)
+    console_write(buffer + flushed, len - flushed);
+  flushed = len;
+  enabled = false;
+}
+
+void
+log_unbuffer()
+{ Boot_log::error(); }
+
+void
+Boot_log::add_module(Internal_module_list &mods)
+{
+  if (!enabled)
+    return;
+
+  unsigned long size = l4_round_page(Buffer_size);
+  unsigned long addr = mem_manager->find_free_ram(size);
+  if (!addr)
+    {
+      printf("  Could not allocate memory for the boot log.\n");
+      return;
+    }
+
+  mem_manager->regions->add(Region::start_size(addr, size, ".bootlog",
+                                                Region::Root));
+  log_module.addr = addr;
+  log_module.size = size;
+  mods.push_front(&log_module);
+}
+
+void
+Boot_log::finish()
+{
+  if (!enabled)
+    return;
+
+  flush();
+  enabled = false;
+
+  if (!log_module.addr)
+    return;
+
+  char *m = reinterpret_cast<char *>(log_module.addr);
+  unsigned long n = cxx::min(len, log_module.size - 1);
+  memcpy(m, buffer, n);
+  m[n] = '\0';
+}
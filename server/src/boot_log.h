@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include "boot_modules.h"
+
+/**
+ * In-memory buffer for the console output of bootstrap.
+ *
+ * Polling the UART for every character is slow. With `-bootlog`, the output
+ * is collected in memory and only written to the UART when waiting for input,
+ * on errors and before starting the kernel. With `-quiet`, the buffered output
+ * is only written to the UART on errors, together with the error messages. In
+ * both cases the output is handed to the root task as internal module
+ * ".bootlog".
+ */
+class Boot_log
+{
+public:
+  enum { Buffer_size = 32 << 10 };
+
+  /**
+   * Collect the console output in memory from now on.
+   *
+   * \param quiet  Do not write the collected output to the UART.
+   */
+  static void enable(bool quiet);
+
+  /**
+   * Append console output to the buffer.
+   *
+   * \retval true   The output was buffered.
+   * \retval false  Buffering is disabled, the caller shall write the output.
+   */
+  static bool write(char const *s, unsigned long len);
+
+  /// Write the pending buffered output to the UART unless in quiet mode.
+  static void flush();
+
+  /**
+   * Stop buffering to get error messages out immediately.
+   *
+   * The output not yet written to the UART is written first, also in quiet
+   * mode.
+   */
+  static void error();
+
+  /**
+   * Reserve memory for the log and add the ".bootlog" module.
+   *
+   * Must be called before the boot modules are placed.
+   */
+  static void add_module(Internal_module_list &mods);
+
+  /// Flush the buffer, write it to the ".bootlog" module and stop buffering.
+  static void finish();
+};
@@ -1,8 +1,12 @@
 #include "boot_modules.h"
+#include "boot_timing.h"
+#include "bulk_copy.h"
 #include "memory.h"
+#include "mp_workers.h"
 #include "platform.h"
 #include "support.h"
 #include "panic.h"
+#include "timestamp.h"
 #include <assert.h>
 #include "mod_info.h"
 
@@ -10,6 +14,7 @@
 #include "uncompress.h"
 #endif
 
+#include <l4/cxx/minmax>
 #include <l4/sys/types.h>
 #include <l4/util/mb_info.h>
 #include <l4/util/printf_helpers.h>
@@ -146,11 +151,10 @@ Boot_modules::_move_module(unsigned index, void *dest,
   char const *vsrc = reinterpret_cast<char const *>(p->to_virt(src_addr));
   char *vdest = reinterpret_cast<char *>(p->to_virt(dest_addr));
 
-  char size_str[64];
-  l4util_human_readable_size(size_str, sizeof(size_str), size);
-
-  if (Verbose_load)
+  if (log_enabled(Log_debug))
     {
+      char size_str[64];
+      l4util_human_readable_size(size_str, sizeof(size_str), size);
       char magic_str[5] =
       {
         get_printable(vsrc[0]), get_printable(vsrc[1]), get_printable(vsrc[2]),
@@ -169,10 +173,14 @@ Boot_modules::_move_module(unsigned index, void *dest,
         }
       printf("\n");
     }
-  else
-    printf("  moving module %02d { %lx-%lx } -> { %lx-%lx } [%s]\n",
-           index, src_addr, src_addr + size - 1,
-           dest_addr, dest_addr + size - 1, size_str);
+  else if (log_enabled(Log_verbose))
+    {
+      char size_str[64];
+      l4util_human_readable_size(size_str, sizeof(size_str), size);
+      printf("  moving module %02d { %lx-%lx } -> { %lx-%lx } [%s]\n",
+             index, src_addr, src_addr + size - 1,
+             dest_addr, dest_addr + size - 1, size_str);
+    }
 
   if (!mem_manager->ram->contains(dest))
     panic("Would move module outside of RAM");
@@ -182,16 +190,24 @@ Boot_modules::_move_module(unsigned index, void *dest,
       Region *overlap = mem_manager->regions->find(dest);
       if (overlap)
         {
-          printf("ERROR: module target [%p-%p) overlaps\n",
+          log_error("ERROR: module target [%p-%p) overlaps\n",
                  dest, static_cast<char *>(dest) + size - 1);
           overlap->vprint(true);
           mem_manager->regions->dump();
           panic("Cannot move module");
         }
     }
-  memmove(vdest, vsrc, size);
+  l4_uint64_t start = timestamp();
+  if (vdest + size <= vsrc || vsrc + size <= vdest)
+    Mp_workers::copy(reinterpret_cast<l4_addr_t>(vdest),
+                     reinterpret_cast<l4_addr_t>(vsrc), size);
+  else
+    bulk_move(vdest, vsrc, size);
   char *x = vdest + size;
-  memset(x, 0, l4_round_page(x) - x);
+  bulk_zero(x, l4_round_page(x) - x);
+  Boot_timing::module(Boot_timing::Move, index < num_modules()
+                                         ? module(index, false).cmdline : name,
+                      start, size);
   mem_manager->regions->add(Region::start_size(dest, size, name, type, subtype));
 }
 
@@ -275,14 +291,14 @@ Boot_modules::move_modules(unsigned long modaddr)
       return r->name() == Mod_info::Mod_reg;
     });
 
-  printf("  Moving up to %d modules behind %lx\n", count, modaddr);
+  log_verbose("  Moving up to %d modules behind %lx\n", count, modaddr);
   unsigned long req_size = calc_modules_size(this, L4_PAGESHIFT);
 
   // find a spot to insert the modules
   char *to = (char *)mem_manager->find_free_ram(req_size, modaddr);
   if (!to)
     {
-      printf("Need %lx bytes above %lx:\n", req_size, modaddr);
+      log_error("Need %lx bytes above %lx:\n", req_size, modaddr);
       mem_manager->ram->dump();
       mem_manager->regions->dump();
       panic("Could not find free RAM region for modules!");
@@ -362,6 +378,7 @@ static void modinfo_gen_payload_size()
       max_payload_addr_str(m.cmdline());
       max_payload_addr_str(m.md5sum_compr());
       max_payload_addr_str(m.md5sum_uncompr());
+      max_payload_addr(reinterpret_cast<l4_addr_t>(m.attrs().data_end()));
     }
 }
 
@@ -388,7 +405,7 @@ void init_modules_infos()
   image_info.attrs             += image_info_addr;
 
   // Debugging help, shall be removed in final version
-  if (Verbose_load)
+  if (log_enabled(Log_debug))
     {
       printf("image_info=%p Version: %d\n", &image_info, image_info.version);
       printf("   image_info.module_data_start=%llx\n", image_info.module_data_start);
@@ -403,11 +420,25 @@ void init_modules_infos()
 
   modinfo_gen_payload_size();
 
-  if (Verbose_load)
+  if (log_enabled(Log_debug))
     printf("module-infos are at %p (size: %lu, num-modules: %d)\n",
            mod_header, modinfo_payload_size(), mod_header->num_mods());
 }
 
+/**
+ * Use the module payload at `hdr` instead of the one linked into the image.
+ *
+ * Must be called before the module regions are initialized.
+ */
+void use_modules_infos(Mod_header *hdr)
+{
+  assert((reinterpret_cast<unsigned long>(hdr) & 7ul) == 0);
+
+  mod_header = hdr;
+  modinfo_max_payload_addr = 0;
+  modinfo_gen_payload_size();
+}
+
 
 namespace {
 /*
@@ -434,7 +465,7 @@ drop_mod_region(Mod_info *mod)
 static inline void
 print_mod(Mod_info const *mod)
 {
-  printf("  mod%02u: %8p-%8p: %s\n",
+  log_verbose("  mod%02u: %8p-%8p: %s\n",
          mod->index(), mod->start(), mod->start() + mod->size(), mod->name());
 }
 #endif
@@ -442,20 +473,23 @@ print_mod(Mod_info const *mod)
 #ifdef DO_CHECK_MD5
 #include <bsd/md5.h>
 
-static void check_md5(const char *name, void const *start, unsigned size,
-                      const char *md5sum)
+static void md5_digest(void const *start, unsigned size,
+                       unsigned char *digest)
 {
   MD5_CTX md5ctx;
-  unsigned char digest[MD5_DIGEST_LENGTH];
+  MD5Init(&md5ctx);
+  MD5Update(&md5ctx, (const uint8_t *)start, size);
+  MD5Final(digest, &md5ctx);
+}
+
+static void md5_verify(const char *name, unsigned char const *digest,
+                       const char *md5sum)
+{
   char s[MD5_DIGEST_STRING_LENGTH];
   static const char hex[] = "0123456789abcdef";
   int j;
 
-  printf("  Checking checksum of %s ... ", name);
-
-  MD5Init(&md5ctx);
-  MD5Update(&md5ctx, (const uint8_t *)start, size);
-  MD5Final(digest, &md5ctx);
+  log_info("  Checking checksum of %s ... ", name);
 
   for (j = 0; j < MD5_DIGEST_LENGTH; j++)
     {
@@ -467,11 +501,73 @@ static void check_md5(const char *name, void const *start, unsigned size,
   if (strcmp(s, md5sum))
     panic("\nmd5sum mismatch");
   else
-    printf("Ok.\n");
+    log_info("Ok.\n");
+}
+
+static void check_md5(const char *name, void const *start, unsigned size,
+                      const char *md5sum)
+{
+  unsigned char digest[MD5_DIGEST_LENGTH];
+
+  l4_uint64_t ts = timestamp();
+  md5_digest(start, size, digest);
+  Boot_timing::module(Boot_timing::Hash, name, ts, size);
+  md5_verify(name, digest, md5sum);
+}
+
+/**
+ * Check the checksums of all modules, hashing them on all CPUs.
+ *
+ * \param compressed  Only check the compressed modules against their
+ *                    compressed checksum. Otherwise check all modules against
+ *                    their uncompressed checksum.
+ */
+static void check_md5s(bool compressed)
+{
+  struct Result
+  {
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    l4_uint64_t ticks;
+  };
+  static Result results[MODS_MAX];
+  static unsigned first;
+
+  unsigned num = mod_header->num_mods();
+  for (first = 0; first < num; first += MODS_MAX)
+    {
+      unsigned n = num - first < MODS_MAX ? num - first : MODS_MAX;
+      Mp_workers::run(n, [](unsigned i, void *arg) -> l4_size_t
+        {
+          Mod_info const *mod = mod_header->mods()[first + i];
+          bool compressed = *static_cast<bool *>(arg);
+          if (compressed && (mod->is_base_module() || !mod->compressed()))
+            return 0;
+
+          l4_uint64_t ts = timestamp();
+          md5_digest(mod->start(), mod->size(), results[i].digest);
+          results[i].ticks = timestamp() - ts;
+          return mod->size();
+        }, &compressed);
+
+      for (unsigned i = 0; i < n; ++i)
+        {
+          Mod_info const *mod = mod_header->mods()[first + i];
+          if (compressed && (mod->is_base_module() || !mod->compressed()))
+            continue;
+
+          Boot_timing::account(Boot_timing::Hash, mod->name(),
+                               results[i].ticks, mod->size());
+          md5_verify(mod->name(), results[i].digest,
+                     compressed ? mod->md5sum_compr() : mod->md5sum_uncompr());
+        }
+    }
 }
 #else // DO_CHECK_MD5
 static inline void check_md5(const char *, void const *, unsigned, const char *)
 {}
+
+static inline void check_md5s(bool)
+{}
 #endif // ! DO_CHECK_MD5
 
 #ifdef CONFIG_BOOTSTRAP_COMPRESS
@@ -485,11 +581,14 @@ decompress_mod(Mod_info *mod, l4_addr_t dest, Region::Type type = Region::Boot)
   if (!mem_manager->ram->contains(Region::start_size(dest, dest_size)))
     panic("Module %s does not fit into RAM", mod->name());
 
+  l4_uint64_t start = timestamp();
   l4_addr_t image =
     reinterpret_cast<l4_addr_t>(decompress(mod->name(), mod->start(),
                                            reinterpret_cast<char *>(dest),
                                            mod->size(),
                                            mod->size_uncompressed()));
+  Boot_timing::module(Boot_timing::Inflate, mod->name(), start, dest_size,
+                      mod->size());
   if (image != dest)
     panic("Cannot decompress module: %s (decompression error)", mod->name());
 
@@ -579,7 +678,7 @@ decomp_move_mod(Mod_info *mod, char *destbuf)
     decompress_mod(mod, (l4_addr_t)destbuf, Region::Root);
   else
     {
-      memmove(destbuf, mod->start(), mod->size_uncompressed());
+      bulk_move(destbuf, mod->start(), mod->size_uncompressed());
 #if 0 // cannot simply zero this out, this might overlap with
       // the next module to decompress
       l4_addr_t dest_size = l4_round_page( mod->size_uncompressed);
@@ -595,13 +694,162 @@ decomp_move_mod(Mod_info *mod, char *destbuf)
   print_mod(mod);
 }
 
+/**
+ * Safety margin for decompressing a module over its own data.
+ *
+ * The compressed data must end at least this far behind the end of the
+ * decompressed module so that inflate never overwrites input it has not yet
+ * consumed. This is the same margin the Linux kernel uses for its
+ * self-decompressing images.
+ */
+static unsigned long
+inplace_margin(Mod_info const *mod)
+{
+  if (!mod->compressed())
+    return 0;
+
+  return (mod->size_uncompressed() >> 12) + (64 << 10) + 128;
+}
+
+/**
+ * Decompress the modules without a separate destination buffer.
+ *
+ * The compressed data of all modules is first moved to the end of the area,
+ * highest module first. The modules are then decompressed to the start of
+ * the area, lowest module first, so the output of a module only overwrites
+ * compressed data which has already been consumed. The area must cover the
+ * decompressed modules below a module, the module itself with its safety
+ * margin and the compressed modules above it. Hence only a single margin is
+ * needed on top of the uncompressed size of all modules and the area starts
+ * at the first compressed module, so it overlaps the compressed data as far
+ * as possible.
+ *
+ * The module infos (.modinfo) directly follow the module data in the image
+ * and base modules might be placed between the compressed modules. They are
+ * moved behind the area first.
+ *
+ * \pre The module regions of the non-base modules are removed.
+ *
+ * \retval true   Modules decompressed.
+ * \retval false  Not enough free memory behind the compressed modules.
+ */
+static bool
+decompress_mods_inplace()
+{
+  unsigned num = mod_sorter_num();
+  Mod_info_list mods = mod_header->mods();
+  Mod_info const *first = mods[mod_sorter[0]];
+
+  unsigned long compr = 0;
+  for (unsigned i = 0; i < num; ++i)
+    compr += mods[mod_sorter[i]]->size();
+
+  // Size of the area needed while decompressing each of the modules
+  unsigned long size = 0;
+  unsigned long uncompr = 0;
+  for (unsigned i = 0; i < num; ++i)
+    {
+      Mod_info const *mod = mods[mod_sorter[i]];
+      compr -= mod->size();
+      uncompr += l4_round_page(mod->size_uncompressed());
+      size = cxx::max(size, uncompr + inplace_margin(mod) + compr);
+    }
+
+  char *start = const_cast<char *>(l4_round_page(first->start()));
+
+  // Data above the start of the area which is still needed
+  Region hdr = mod_header_region();
+  char const *top = start;
+  unsigned long keep = 0;
+  for (Mod_info const &mod : mods)
+    if (mod.start() >= start)
+      {
+        top = cxx::max(top, mod.start() + mod.size());
+        if (mod.is_base_module())
+          keep += l4_round_page(mod.size());
+      }
+
+  bool move_hdr = hdr.begin() >= reinterpret_cast<l4_addr_t>(start);
+  if (move_hdr)
+    {
+      top = cxx::max(top, reinterpret_cast<char const *>(hdr.end() + 1));
+      keep += l4_round_page(hdr.size());
+    }
+
+  char *end = cxx::max(const_cast<char *>(l4_round_page(start + size)),
+                       const_cast<char *>(l4_round_page(top)));
+
+  // The module regions left are those of the base modules
+  Region dest = Region::array(start, end - start + keep);
+  bool fits = mem_manager->ram->contains(dest);
+  for (Region const &r : *mem_manager->regions)
+    if (fits && r.overlaps(dest) && r.name() != Mod_info::Mod_reg
+        && !(move_hdr && r.contains(hdr)))
+      fits = false;
+
+  if (!fits)
+    {
+      log_warn("  cannot decompress in place at [%p-%p)\n",
+               start, end + keep);
+      return false;
+    }
+
+  log_info("Uncompressing modules in place (modaddr = %p):\n", start);
+
+  // Behind the area is no data of the modules, neither can overlap
+  char *kept = end;
+  for (Mod_info &mod : mods)
+    if (mod.is_base_module() && mod.start() >= start)
+      {
+        bulk_move(kept, mod.start(), mod.size());
+        drop_mod_region(&mod);
+        mod.start(kept);
+        mem_manager->regions->add(mod.region());
+        kept += l4_round_page(mod.size());
+      }
+
+  if (move_hdr)
+    {
+      // Only the module starts are relative to the old location
+      l4_addr_t delta = reinterpret_cast<l4_addr_t>(kept) - hdr.begin();
+      bulk_move(kept, reinterpret_cast<void const *>(hdr.begin()), hdr.size());
+      mem_manager->regions->sub(hdr);
+      use_modules_infos(reinterpret_cast<Mod_header *>(kept));
+      mods = mod_header->mods();
+      for (Mod_info &mod : mods)
+        mod.start(mod.start() - delta);
+      mem_manager->regions->add(mod_header_region());
+    }
+
+  // Moving the data upwards, it never overwrites data not yet moved
+  char *src = end;
+  for (unsigned i = num; i > 0; --i)
+    {
+      Mod_info *mod = mods[mod_sorter[i - 1]];
+      src -= mod->size();
+      bulk_move(src, mod->start(), mod->size());
+      mod->start(src);
+    }
+
+  char *destbuf = start;
+  for (unsigned i = 0; i < num; ++i)
+    {
+      Mod_info *mod = mods[mod_sorter[i]];
+      unsigned long dest_size = l4_round_page(mod->size_uncompressed());
+      decomp_move_mod(mod, destbuf);
+      destbuf += dest_size;
+    }
+
+  return true;
+}
+
 void
 Boot_modules_image_mode::decompress_mods(l4_addr_t total_size, l4_addr_t mod_addr)
 {
   Mod_info *mod_info = mod_header->mods().begin();
   assert (mod_header->num_mods() > Mod_info::Num_base_modules);
 
-  printf("Compressed modules:\n");
+  log_verbose("Compressed modules:\n");
   for (Mod_info const &mod : mod_header->mods())
     {
       if (mod.compressed())
@@ -638,7 +886,7 @@ Boot_modules_image_mode::decompress_mods(l4_addr_t total_size, l4_addr_t mod_add
           char const *mstart = mod.start();
           char const *mend = mod.start() + mod.size();
           // remove the module region for now
-          mem_manager->regions->remove_if([mod](Region const *r)->bool
+          mem_manager->regions->remove_if([&mod](Region const *r)->bool
             {
               return r->name() == Mod_info::Mod_reg && r->sub_type() == mod.index();
             });
@@ -671,7 +919,7 @@ Boot_modules_image_mode::decompress_mods(l4_addr_t total_size, l4_addr_t mod_add
       fwd = true;
       if (!ldest || !mem_manager->ram->contains(dest) || mem_manager->regions->find(dest))
         {
-          printf("  cannot decompress at %p, try %p\n", ldest, rdest);
+          log_verbose("  cannot decompress at %p, try %p\n", ldest, rdest);
           dest = Region::array(rdest, total_size); // try the move behind version
           destbuf = const_cast<char *>(rdest);
           fwd = false;
@@ -682,18 +930,20 @@ Boot_modules_image_mode::decompress_mods(l4_addr_t total_size, l4_addr_t mod_add
                 = mem_manager->find_free_ram(total_size,
                                              reinterpret_cast<l4_addr_t>(rdest));
               destbuf = reinterpret_cast<char *>(free_ram);
-              printf("  cannot decompress at %p, use %p\n", rdest, destbuf);
+              log_verbose("  cannot decompress at %p, use %p\n", rdest, destbuf);
             }
         }
     }
 
   if (!destbuf)
-    panic("Cannot find memory to  decompress modules");
-
-  printf("Uncompressing modules (modaddr = %p (%s)):\n", destbuf,
-         fwd ? "forwards" : "backwards");
-  if (!fwd)
     {
+      if (!decompress_mods_inplace())
+        panic("Cannot find memory to  decompress modules");
+    }
+  else if (!fwd)
+    {
+      log_info("Uncompressing modules (modaddr = %p (backwards)):\n", destbuf);
+
       // advance to last module end
       destbuf += total_size;
 
@@ -709,6 +959,8 @@ Boot_modules_image_mode::decompress_mods(l4_addr_t total_size, l4_addr_t mod_add
     }
   else
     {
+      log_info("Uncompressing modules (modaddr = %p (forwards)):\n", destbuf);
+
       for (unsigned i = 0; i < mod_sorter_num(); ++i)
         {
           Mod_info *mod = mod_header->mods()[mod_sorter[i]];
@@ -736,7 +988,7 @@ Boot_modules_image_mode::decompress_mods(l4_addr_t total_size, l4_addr_t mod_add
               l4_uint64_t to = mem_manager->find_free_ram(mod.size());
               if (!to)
                 {
-                  printf("Need %x bytes:\n", mod.size());
+                  log_error("Need %x bytes:\n", mod.size());
                   mem_manager->ram->dump();
                   mem_manager->regions->dump();
                   panic("Could not find free RAM region for module!");
@@ -762,13 +1014,11 @@ Boot_modules_image_mode::construct_mbi(unsigned long mod_addr, Internal_module_l
         panic("Module %hu '%s' empty, modules must not have zero size.",
               mod.index(), mod.name());
       if (!mod.is_base_module())
-        {
-          total_size += l4_round_page(mod.size_uncompressed());
-          if (mod.compressed())
-            check_md5(mod.name(), mod.start(), mod.size(), mod.md5sum_compr());
-        }
+        total_size += l4_round_page(mod.size_uncompressed());
     }
 
+  check_md5s(true);
+
 #ifdef CONFIG_BOOTSTRAP_COMPRESS
   if (mod_header->num_mods() > Mod_info::Num_base_modules)
     decompress_mods(total_size, mod_addr);
@@ -777,6 +1027,7 @@ Boot_modules_image_mode::construct_mbi(unsigned long mod_addr, Internal_module_l
   move_modules(mod_addr);
 #endif // ! CONFIG_BOOTSTRAP_COMPRESS
   merge_mod_regions();
+  check_md5s(false);
 
   unsigned long mod_count = mod_header->num_mods() + internal_mods.cnt;
 
@@ -817,9 +1068,6 @@ Boot_modules_image_mode::construct_mbi(unsigned long mod_addr, Internal_module_l
             || (run == 1 &&  mod.is_base_module()))
           continue;
 
-        check_md5(mod.name(), mod.start(),
-                  mod.size_uncompressed(), mod.md5sum_uncompr());
-
         if (char const *c = mod.cmdline())
           {
             unsigned l = strlen(c) + 1;
@@ -853,7 +1101,7 @@ Boot_modules_image_mode::move_module(unsigned index, void *dest)
       if (show_once)
         {
           show_once = false;
-          printf("  Using 'modaddr %#llx' in modules.list might prevent moving modules.\n",
+          log_warn("  Using 'modaddr %#llx' in modules.list might prevent moving modules.\n",
                  l4_uint64_t{LINKADDR} - RAM_BASE);
         }
     }
@@ -862,3 +1110,152 @@ Boot_modules_image_mode::move_module(unsigned index, void *dest)
                Region::Root, Region::No_subtype);
   mod->start(reinterpret_cast<char const *>(dest));
 }
+
+static bool
+is_list_space(char c)
+{ return c == ' ' || c == '\t' || c == '\r'; }
+
+void
+Boot_modules_list::parse_list()
+{
+  for (char *line = _list; *line;)
+    {
+      char *next = strchr(line, '\n');
+      if (next)
+        *next++ = 0;
+      else
+        next = line + strlen(line);
+
+      while (is_list_space(*line))
+        ++line;
+
+      char *end = line + strlen(line);
+      while (end > line && is_list_space(end[-1]))
+        *--end = 0;
+
+      if (*line && *line != '#')
+        {
+          if (_num_mods == Max_mods)
+            panic("More than %d modules in module list.", Max_mods);
+
+          char *cmdline = line;
+          while (*cmdline && !is_list_space(*cmdline))
+            ++cmdline;
+          if (*cmdline)
+            *cmdline++ = 0;
+          while (is_list_space(*cmdline))
+            ++cmdline;
+
+          Mod &m = _mods[_num_mods++];
+          m.name    = line;
+          m.cmdline = *cmdline ? cmdline : line;
+          m.size    = 0;
+          m.addr    = 0;
+        }
+
+      line = next;
+    }
+}
+
+void
+Boot_modules_list::add_region(unsigned index, l4_addr_t addr,
+                              unsigned long size, Region::Type type)
+{
+  _mods[index].addr = addr;
+  _mods[index].size = size;
+  mem_manager->regions->add(mod_region(index, addr, size, type));
+}
+
+Boot_modules::Module
+Boot_modules_list::module(unsigned index, bool) const
+{
+  Mod const &mod = _mods[index];
+  Module m;
+  m.start   = reinterpret_cast<char const *>(mod.addr);
+  m.end     = m.start + (mod.addr ? mod.size : 0);
+  m.cmdline = mod.cmdline;
+  return m;
+}
+
+void
+Boot_modules_list::move_module(unsigned index, void *dest)
+{
+  Mod &m = _mods[index];
+  _move_module(index, dest, reinterpret_cast<void const *>(m.addr), m.size,
+               Mod_info::Mod_reg, Region::Root, Region::No_subtype);
+  m.addr = reinterpret_cast<l4_addr_t>(dest);
+}
+
+int
+Boot_modules_list::base_mod_idx(l4util_l4mod_mod_info_flag mod_info_mod_type,
+                                unsigned)
+{
+  switch (mod_info_mod_type)
+    {
+    case L4util_l4mod_mod_flag_kernel:
+    case L4util_l4mod_mod_flag_sigma0:
+    case L4util_l4mod_mod_flag_roottask:
+      if (mod_info_mod_type - 1 < (int)_num_mods)
+        return mod_info_mod_type - 1;
+      // fall through
+    default:
+      return -1;
+    }
+}
+
+l4util_l4mod_info *
+Boot_modules_list::build_mbi(unsigned long mod_addr,
+                             Internal_module_list const &internal_mods)
+{
+  merge_mod_regions();
+
+  unsigned long mod_count = _num_mods + internal_mods.cnt;
+  unsigned long mbi_size = sizeof(l4util_l4mod_info);
+  mbi_size += sizeof(l4util_l4mod_mod) * mod_count;
+
+  for (unsigned i = 0; i < _num_mods; ++i)
+    mbi_size += round_wordsize(strlen(_mods[i].cmdline) + 1);
+
+  for (Internal_module_base const *m = internal_mods.root; m; m = m->next())
+    mbi_size += round_wordsize(m->cmdline_size());
+
+  // Round up to ensure mbi is on its own page
+  unsigned long mbi_size_full = l4_round_page(mbi_size);
+  l4_addr_t mbi_ram = mem_manager->find_free_ram(mbi_size_full, mod_addr);
+  auto *mbi = reinterpret_cast<l4util_l4mod_info *>(mbi_ram);
+  if (!mbi)
+    panic("Could not allocate MBI memory: %lu bytes", mbi_size_full);
+
+  mem_manager->regions->add(Region::start_size(mbi_ram, mbi_size_full,
+                                               ".mbi_rt", Region::Root,
+                                               Region::Root_section_rwx));
+  memset(mbi, 0, mbi_size);
+
+  l4util_l4mod_mod *mods = reinterpret_cast<l4util_l4mod_mod *>(mbi + 1);
+  char *mbi_strs = reinterpret_cast<char *>(mods + mod_count);
+
+  mbi->mods_count = _num_mods;
+  mbi->mods_addr  = reinterpret_cast<l4_addr_t>(mods);
+
+  for (unsigned i = 0; i < _num_mods; ++i)
+    {
+      unsigned l = strlen(_mods[i].cmdline) + 1;
+      mods[i].cmdline = reinterpret_cast<l4_addr_t>(mbi_strs);
+      memcpy(mbi_strs, _mods[i].cmdline, l);
+      mbi_strs += round_wordsize(l);
+
+      mods[i].mod_start = _mods[i].addr;
+      mods[i].mod_end   = _mods[i].addr + _mods[i].size;
+      mods[i].flags     = i < Num_base_mods
+                          ? static_cast<l4util_l4mod_mod_info_flag>(i + 1)
+                          : L4util_l4mod_mod_flag_unspec;
+    }
+
+  for (Internal_module_base const *m = internal_mods.root; m; m = m->next())
+    {
+      m->set(&mods[mbi->mods_count++], mbi_strs);
+      mbi_strs += round_wordsize(m->cmdline_size());
+    }
+
+  return mbi;
+}
@@ -98,6 +98,58 @@ protected:
 
 inline Boot_modules::~Boot_modules() {}
 
+/**
+ * Boot modules which bootstrap reads one by one from a list of files, e.g.
+ * from QEMU fw_cfg or from an EFI file system.
+ *
+ * The list holds one module per line: the file name of the module followed
+ * by its command line. Empty lines and lines starting with '#' are ignored.
+ * As with multiboot, the first three modules are the kernel, sigma0 and the
+ * root task.
+ */
+class Boot_modules_list : public Boot_modules
+{
+public:
+  enum
+  {
+    Max_mods      = 64,
+    Max_list_size = 8 << 10,
+  };
+
+  void finalize_mod_regions() override {}
+  Module module(unsigned index, bool uncompress = true) const override;
+  unsigned num_modules() const override { return _num_mods; }
+  void move_module(unsigned index, void *dest) override;
+  int base_mod_idx(l4util_l4mod_mod_info_flag mod_info_mod_type,
+                   unsigned node = 0) override;
+
+protected:
+  enum { Num_base_mods = 3 };
+
+  struct Mod
+  {
+    char const *name;      ///< File name
+    char const *cmdline;
+    unsigned long size;
+    l4_addr_t addr;        ///< 0 if not yet loaded
+  };
+
+  /// Split the list in `_list` into `_mods`.
+  void parse_list();
+
+  /// Reserve the memory of a loaded module.
+  void add_region(unsigned index, l4_addr_t addr, unsigned long size,
+                  Region::Type type);
+
+  /// Create the MBI once all modules are loaded.
+  l4util_l4mod_info *build_mbi(unsigned long mod_addr,
+                               Internal_module_list const &internal_mods);
+
+  char _list[Max_list_size];
+  Mod _mods[Max_mods];
+  unsigned _num_mods = 0;
+};
+
 /**
  * For image mode we have this utility that implements
  * handling of linked in modules.
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <l4/sys/consts.h>
+#include <l4/util/printf_helpers.h>
+
+#include "boot_timing.h"
+#include "memory.h"
+#include "region.h"
+#include "timestamp.h"
+
+namespace {
+
+struct Timing_module : Internal_module_base
+{
+  Timing_module() : Internal_module_base(".boottime") {}
+
+  void set_region(l4util_l4mod_mod *m) const override
+  {
+    m->mod_start = addr;
+    m->mod_end   = addr + size;
+  }
+
+  l4_addr_t addr = 0;
+  unsigned long size = 0;
+};
+
+Timing_module timing_module;
+
+Boot_timing::Record records[Boot_timing::Max_records];
+unsigned num_records;
+unsigned num_dropped;
+
+/// End of the last phase, the counter starts with 0 at reset.
+l4_uint64_t last_phase_end;
+
+struct Mod_stats
+{
+  char name[Boot_timing::Name_size];
+  l4_uint64_t ticks[Boot_timing::Num_ops];
+  l4_uint64_t bytes[Boot_timing::Num_ops];
+  l4_uint64_t compressed;
+
+  l4_uint64_t total() const
+  {
+    // Copy and Zero are part of Load
+    return ticks[Boot_timing::Move] + ticks[Boot_timing::Inflate]
+           + ticks[Boot_timing::Hash] + ticks[Boot_timing::Load];
+  }
+};
+
+Mod_stats stats[Boot_timing::Max_stats];
+unsigned num_stats;
+unsigned num_stats_dropped;
+
+char const *const op_names[Boot_timing::Num_ops] =
+{ "move", "inflate", "md5", "load", "load copy", "load zero" };
+
+/**
+ * Build a name from an optional prefix and the module command line.
+ *
+ * Only the file name of the module is kept, without path and arguments.
+ */
+void
+set_name(char *dst, char const *what, char const *name)
+{
+  unsigned n = 0;
+  auto put = [&](char c) { if (n < Boot_timing::Name_size - 1) dst[n++] = c; };
+
+  if (what)
+    {
+      for (; *what; ++what)
+        put(*what);
+      put(' ');
+    }
+
+  if (!name)
+    name = "?";
+
+  char const *e = name + strcspn(name, " ");
+  char const *b = e;
+  while (b > name && b[-1] != '/')
+    --b;
+
+  for (; b < e; ++b)
+    put(*b);
+
+  dst[n] = '\0';
+}
+
+Mod_stats *
+find_stats(char const *name)
+{
+  char n[Boot_timing::Name_size];
+  set_name(n, nullptr, name);
+
+  for (unsigned i = 0; i < num_stats; ++i)
+    if (!strcmp(stats[i].name, n))
+      return &stats[i];
+
+  if (num_stats == Boot_timing::Max_stats)
+    {
+      ++num_stats_dropped;
+      return nullptr;
+    }
+
+  Mod_stats *s = &stats[num_stats++];
+  strcpy(s->name, n);
+  return s;
+}
+
+void
+add(Boot_timing::Kind kind, l4_uint64_t start, l4_uint64_t end,
+    char const *what, char const *name)
+{
+  if (num_records == Boot_timing::Max_records)
+    {
+      ++num_dropped;
+      return;
+    }
+
+  Boot_timing::Record *r = &records[num_records++];
+  r->start = start;
+  r->end = end;
+  r->kind = kind;
+  if (what)
+    set_name(r->name, what, name);
+  else
+    {
+      strncpy(r->name, name, sizeof(r->name) - 1);
+      r->name[sizeof(r->name) - 1] = '\0';
+    }
+}
+
+void
+print_duration(char const *name, l4_uint64_t ticks)
+{
+  l4_uint64_t us = timestamp_to_us(ticks);
+  if (us || !ticks)
+    printf("    %-32s %8llu.%03llu ms\n", name, us / 1000, us % 1000);
+  else
+    printf("    %-32s %12llu ticks\n", name, ticks);
+}
+
+}
+
+void
+Boot_timing::phase(char const *name)
+{
+  l4_uint64_t now = timestamp();
+  add(Phase, last_phase_end, now, nullptr, name);
+  last_phase_end = now;
+}
+
+void
+Boot_timing::module(Op op, char const *name, l4_uint64_t start,
+                    l4_uint64_t bytes, l4_uint64_t src_bytes)
+{
+  l4_uint64_t end = timestamp();
+  add(Module, start, end, op_names[op], name);
+  account(op, name, end - start, bytes);
+  if (op == Inflate)
+    if (Mod_stats *s = find_stats(name))
+      s->compressed += src_bytes;
+}
+
+void
+Boot_timing::account(Op op, char const *name, l4_uint64_t ticks,
+                     l4_uint64_t bytes)
+{
+  if (Mod_stats *s = find_stats(name))
+    {
+      s->ticks[op] += ticks;
+      s->bytes[op] += bytes;
+    }
+}
+
+void
+Boot_timing::add_module(Internal_module_list &mods)
+{
+  unsigned long size = l4_round_page(sizeof(Header)
+                                     + sizeof(Record) * Max_records);
+  unsigned long addr = mem_manager->find_free_ram(size);
+  if (!addr)
+    {
+      printf("  Could not allocate memory for boot timing records.\n");
+      return;
+    }
+
+  mem_manager->regions->add(Region::start_size(addr, size, ".boottime",
+                                                Region::Root));
+  timing_module.addr = addr;
+  timing_module.size = size;
+  mods.push_front(&timing_module);
+}
+
+void
+Boot_timing::print()
+{
+  enum { Num_slowest = 10 };
+
+  l4_uint64_t freq = timestamp_freq();
+  printf("  Boot timing (counter at %llu Hz):\n", freq);
+
+  l4_uint64_t first = 0;
+  bool have_first = false;
+  for (unsigned i = 0; i < num_records; ++i)
+    if (records[i].kind == Phase)
+      {
+        print_duration(records[i].name, records[i].end - records[i].start);
+        // The first phase is spent before bootstrap
+        if (!have_first)
+          {
+            first = records[i].end;
+            have_first = true;
+          }
+      }
+
+  print_duration("bootstrap total", last_phase_end - first);
+
+  // Show the slowest module operations, without sorting the records
+  unsigned shown[Num_slowest];
+  unsigned num_shown = 0;
+  for (; num_shown < Num_slowest; ++num_shown)
+    {
+      unsigned best = ~0U;
+      for (unsigned i = 0; i < num_records; ++i)
+        {
+          Record const &r = records[i];
+          if (r.kind != Module)
+            continue;
+
+          bool seen = false;
+          for (unsigned j = 0; j < num_shown; ++j)
+            seen |= shown[j] == i;
+
+          if (!seen && (best == ~0U
+                        || r.end - r.start > records[best].end - records[best].start))
+            best = i;
+        }
+
+      if (best == ~0U)
+        break;
+
+      if (num_shown == 0)
+        printf("  Slowest module operations:\n");
+
+      shown[num_shown] = best;
+      print_duration(records[best].name,
+                     records[best].end - records[best].start);
+    }
+
+  if (num_dropped)
+    printf("  %u timing records dropped.\n", num_dropped);
+}
+
+void
+Boot_timing::print_stats()
+{
+  // Sort by total time, most expensive first
+  unsigned short order[Max_stats];
+  for (unsigned i = 0; i < num_stats; ++i)
+    {
+      unsigned j = i;
+      for (; j > 0 && stats[order[j - 1]].total() < stats[i].total(); --j)
+        order[j] = order[j - 1];
+      order[j] = i;
+    }
+
+  printf("  Module statistics, top offenders first:\n");
+  for (unsigned i = 0; i < num_stats; ++i)
+    {
+      Mod_stats const &s = stats[order[i]];
+      print_duration(s.name, s.total());
+
+      for (unsigned op = 0; op < Num_ops; ++op)
+        {
+          if (!s.ticks[op] && !s.bytes[op])
+            continue;
+
+          l4_uint64_t us = timestamp_to_us(s.ticks[op]);
+          char size[16];
+          l4util_human_readable_size(size, sizeof(size), s.bytes[op]);
+          printf("      %-10s %9s", op_names[op], size);
+          if (op == Inflate && s.compressed)
+            printf(" (%llu%% compressed)",
+                   s.bytes[op] ? s.compressed * 100 / s.bytes[op] : 0ULL);
+          if (us)
+            printf(" in %llu.%03llu ms, %llu MiB/s", us / 1000, us % 1000,
+                   ((s.bytes[op] >> 10) * 1000000 / us) >> 10);
+          else
+            printf(" in %llu ticks", s.ticks[op]);
+          putchar('\n');
+        }
+    }
+
+  if (num_stats_dropped)
+    printf("  %u module statistics dropped.\n", num_stats_dropped);
+}
+
+void
+Boot_timing::finish()
+{
+  if (!timing_module.addr)
+    return;
+
+  Header *h = reinterpret_cast<Header *>(timing_module.addr);
+  h->magic = Magic;
+  h->version = Version;
+  h->num_records = num_records;
+  h->record_size = sizeof(Record);
+  h->freq = timestamp_freq();
+  memcpy(h + 1, records, sizeof(Record) * num_records);
+}
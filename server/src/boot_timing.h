@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include <l4/sys/l4int.h>
+#include "boot_modules.h"
+
+/**
+ * Timing records of the bootstrap phases and of the work done per module.
+ *
+ * The records are printed before starting the kernel and handed to the root
+ * task as internal module ".boottime" with the layout below. All times are in
+ * ticks of the architectural counter (cntvct_el0, rdtsc, rdtime, CP0 count)
+ * which usually starts at reset; the first phase therefore covers the time
+ * before bootstrap was entered.
+ *
+ * Additionally, the time and bytes spent per module are accumulated per kind
+ * of work in a statistics table which is printed with `-bootstats`.
+ */
+class Boot_timing
+{
+public:
+  enum
+  {
+    Magic          = 0x4d495442, ///< "BTIM" on little-endian machines
+    Version        = 1,
+    Max_records    = 192,
+    Name_size      = 44,
+    Max_stats      = 64,
+  };
+
+  /// Kind of work done on a module.
+  enum Op
+  {
+    Move,     ///< Moving the module, _move_module()
+    Inflate,  ///< Decompressing the module
+    Hash,     ///< Checking the MD5 sum
+    Load,     ///< Loading the ELF binary, including Copy and Zero
+    Copy,     ///< Copying ELF segments
+    Zero,     ///< Clearing the BSS part of ELF segments
+    Num_ops
+  };
+
+  enum Kind : l4_uint32_t
+  {
+    Phase  = 0, ///< Bootstrap phase, e.g. setting up the memory map
+    Module = 1, ///< Work on a single module, e.g. moving or loading it
+  };
+
+  /// Header of the ".boottime" module.
+  struct Header
+  {
+    l4_uint32_t magic;        ///< Magic
+    l4_uint32_t version;      ///< Version
+    l4_uint32_t num_records;  ///< Number of records following the header
+    l4_uint32_t record_size;  ///< sizeof(Record)
+    l4_uint64_t freq;         ///< Counter frequency in Hz, 0 if unknown
+  };
+
+  /// Record of the ".boottime" module.
+  struct Record
+  {
+    l4_uint64_t start;        ///< Counter value at the start
+    l4_uint64_t end;          ///< Counter value at the end
+    l4_uint32_t kind;         ///< See Kind
+    char name[Name_size];     ///< 0-terminated, possibly truncated name
+  };
+
+  /**
+   * Record the end of a phase, which started at the end of the previous one.
+   *
+   * \param name  Name of the phase, a string constant.
+   */
+  static void phase(char const *name);
+
+  /**
+   * Record work on a module and account it in the module statistics.
+   *
+   * \param op         Kind of work.
+   * \param name       Module name or command line.
+   * \param start      Counter value when the work started.
+   * \param bytes      Bytes written.
+   * \param src_bytes  Bytes read if different, e.g. the compressed size.
+   */
+  static void module(Op op, char const *name, l4_uint64_t start,
+                     l4_uint64_t bytes, l4_uint64_t src_bytes = 0);
+
+  /**
+   * Account work on a module in the module statistics only.
+   *
+   * For fine-grained work which would flood the exported records.
+   */
+  static void account(Op op, char const *name, l4_uint64_t ticks,
+                      l4_uint64_t bytes);
+
+  /**
+   * Reserve memory for the exported records and add the ".boottime" module.
+   *
+   * Must be called before the boot modules are placed.
+   */
+  static void add_module(Internal_module_list &mods);
+
+  /// Print a summary of all phases and the slowest module operations.
+  static void print();
+
+  /// Print the module statistics, the most expensive modules first.
+  static void print_stats();
+
+  /// Write the records to the ".boottime" module.
+  static void finish();
+};
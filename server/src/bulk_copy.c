@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <l4/sys/l4int.h>
+
+#include "bulk_copy.h"
+#include "memcpy_aligned.h"
+
+enum Bulk_copy_kernel
+{
+  Bulk_copy_generic,   ///< Portable word copy (ldp/stp on arm64).
+  Bulk_copy_rep_movsb, ///< x86 with Enhanced REP MOVSB/STOSB (ERMS).
+};
+
+static enum Bulk_copy_kernel bulk_copy_kernel = Bulk_copy_generic;
+
+#if defined(__i386__) || defined(__x86_64__)
+static int have_movnti;
+
+static inline void
+cpuid(l4_uint32_t leaf, l4_uint32_t *eax, l4_uint32_t *ebx, l4_uint32_t *edx)
+{
+  l4_uint32_t a, b, c, d;
+  asm volatile ("cpuid" : "=a" (a), "=b" (b), "=c" (c), "=d" (d)
+                        : "a" (leaf), "c" (0));
+  *eax = a;
+  *ebx = b;
+  *edx = d;
+}
+
+enum
+{
+  CPUF1_EDX_SSE2  = 1 << 26,
+  CPUF7_EBX_ERMS  = 1 << 9,
+  /// Use non-temporal stores for zeroing areas of at least this size
+  Zero_nt_threshold = 4 << 20,
+};
+#endif
+
+#if defined(__riscv)
+/// Zicboz block size, 0 if cbo.zero shall not be used
+static size_t cbo_zero_block_size;
+#endif
+
+void
+bulk_copy_init(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+  l4_uint32_t max_leaf, eax, ebx, edx;
+  cpuid(0, &max_leaf, &ebx, &edx);
+  if (max_leaf >= 1)
+    {
+      cpuid(1, &eax, &ebx, &edx);
+      have_movnti = !!(edx & CPUF1_EDX_SSE2);
+    }
+  if (max_leaf >= 7)
+    {
+      cpuid(7, &eax, &ebx, &edx);
+      if (ebx & CPUF7_EBX_ERMS)
+        bulk_copy_kernel = Bulk_copy_rep_movsb;
+    }
+#endif
+}
+
+/**
+ * Forward copy with an 8-byte aligned destination but a misaligned source.
+ *
+ * Reading only aligned source words and merging them avoids unaligned accesses
+ * which trap on ARM with MMU disabled (bootstrap is built with
+ * -mstrict-align / -mno-unaligned-access). Each word read contains at least
+ * one byte of the source buffer and therefore never crosses into another page.
+ */
+static void
+copy_fwd_shifted(l4_uint8_t *d, l4_uint8_t const *s, size_t size)
+{
+  unsigned off = (l4_addr_t)s & 7;
+  unsigned ls = off * 8;
+  unsigned rs = 64 - ls;
+  l4_uint64_t const *s8 = (l4_uint64_t const *)(s - off);
+  l4_uint64_t *d8 = (l4_uint64_t *)d;
+  size_t words = size / 8;
+
+  l4_uint64_t cur = *s8++;
+  for (size_t i = 0; i < words; ++i)
+    {
+      l4_uint64_t next = *s8++;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      d8[i] = (cur << ls) | (next >> rs);
+#else
+      d8[i] = (cur >> ls) | (next << rs);
+#endif
+      cur = next;
+    }
+
+  d += words * 8;
+  s += words * 8;
+  for (size_t i = 0; i < size % 8; ++i)
+    d[i] = s[i];
+}
+
+static void
+copy_fwd_generic(l4_uint8_t *d, l4_uint8_t const *s, size_t size)
+{
+  // Align the destination first, stores are the more expensive part.
+  while (size && ((l4_addr_t)d & 7))
+    {
+      *d++ = *s++;
+      --size;
+    }
+
+  if ((l4_addr_t)s & 7)
+    copy_fwd_shifted(d, s, size);
+  else
+    memcpy_aligned(d, s, size);
+}
+
+static void
+copy_bwd_generic(l4_uint8_t *d, l4_uint8_t const *s, size_t size)
+{
+  d += size;
+  s += size;
+
+  if ((((l4_addr_t)d ^ (l4_addr_t)s) & 7) == 0)
+    {
+      while (size && ((l4_addr_t)d & 7))
+        {
+          *--d = *--s;
+          --size;
+        }
+
+      l4_uint64_t *d8 = (l4_uint64_t *)d;
+      l4_uint64_t const *s8 = (l4_uint64_t const *)s;
+      for (; size >= 32; size -= 32)
+        {
+          l4_uint64_t a0 = s8[-1];
+          l4_uint64_t a1 = s8[-2];
+          l4_uint64_t a2 = s8[-3];
+          l4_uint64_t a3 = s8[-4];
+          s8 -= 4;
+          d8[-1] = a0;
+          d8[-2] = a1;
+          d8[-3] = a2;
+          d8[-4] = a3;
+          d8 -= 4;
+        }
+      for (; size >= 8; size -= 8)
+        *--d8 = *--s8;
+
+      d = (l4_uint8_t *)d8;
+      s = (l4_uint8_t const *)s8;
+    }
+
+  while (size--)
+    *--d = *--s;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+static void
+copy_fwd_rep_movsb(l4_uint8_t *d, l4_uint8_t const *s, size_t size)
+{
+  asm volatile ("rep movsb"
+                : "+D" (d), "+S" (s), "+c" (size)
+                :
+                : "memory");
+}
+#endif
+
+void
+bulk_move(void *dst, void const *src, size_t size)
+{
+  l4_uint8_t *d = (l4_uint8_t *)dst;
+  l4_uint8_t const *s = (l4_uint8_t const *)src;
+
+  if (d == s || !size)
+    return;
+
+  // Destination overlaps the tail of the source: copy backwards.
+  if (d > s && d < s + size)
+    {
+      copy_bwd_generic(d, s, size);
+      return;
+    }
+
+  switch (bulk_copy_kernel)
+    {
+#if defined(__i386__) || defined(__x86_64__)
+    case Bulk_copy_rep_movsb:
+      copy_fwd_rep_movsb(d, s, size);
+      break;
+#endif
+    default:
+      copy_fwd_generic(d, s, size);
+      break;
+    }
+}
+
+#if defined(__aarch64__)
+static unsigned long
+arm64_sctlr(void)
+{
+  unsigned long c_el, sctlr;
+  asm ("mrs %0, CurrentEL" : "=r" (c_el));
+  switch ((c_el >> 2) & 3)
+    {
+#if __ARM_ARCH_PROFILE != 82
+    case 3:
+      asm ("mrs %0, SCTLR_EL3" : "=r" (sctlr));
+      break;
+#endif
+    case 2:
+      asm ("mrs %0, SCTLR_EL2" : "=r" (sctlr));
+      break;
+    case 1:
+      asm ("mrs %0, SCTLR_EL1" : "=r" (sctlr));
+      break;
+    default:
+      sctlr = 0;
+    }
+  return sctlr;
+}
+
+/**
+ * Return the DC ZVA block size or 0 if DC ZVA cannot be used.
+ *
+ * DC ZVA faults on Device memory. Without MMU and data cache all data accesses
+ * are Device accesses, so the state is checked on every call.
+ */
+static size_t
+zero_block_size(void)
+{
+  unsigned long dczid;
+  asm ("mrs %0, DCZID_EL0" : "=r" (dczid));
+  if (dczid & (1 << 4)) // DZP: DC ZVA prohibited
+    return 0;
+
+  if ((arm64_sctlr() & 5) != 5) // M and C
+    return 0;
+
+  return 4UL << (dczid & 0xf);
+}
+
+static inline void
+zero_block(l4_uint8_t *d)
+{ asm volatile ("dc zva, %0" : : "r" (d) : "memory"); }
+
+#elif defined(__riscv)
+
+void
+bulk_zero_set_cbo_block_size(size_t size)
+{
+  // Must be a power of two
+  cbo_zero_block_size = size & (size - 1) ? 0 : size;
+}
+
+static inline size_t
+zero_block_size(void)
+{ return cbo_zero_block_size; }
+
+static inline void
+zero_block(l4_uint8_t *d)
+{
+  // cbo.zero (Zicboz), encoded manually for older assemblers
+  asm volatile (".insn i 0x0f, 2, x0, %0, 4" : : "r" (d) : "memory");
+}
+
+#elif defined(__i386__) || defined(__x86_64__)
+
+static inline void
+zero_rep_stosb(l4_uint8_t *d, size_t size)
+{
+  asm volatile ("rep stosb"
+                : "+D" (d), "+c" (size)
+                : "a" (0)
+                : "memory");
+}
+
+/**
+ * Zero with non-temporal stores.
+ *
+ * Avoids evicting the whole cache and the read-for-ownership of each line when
+ * clearing large areas (e.g. presetting all RAM).
+ */
+static void
+zero_nt(l4_uint8_t *d, size_t size)
+{
+  size_t head = -(l4_addr_t)d & 63;
+  zero_rep_stosb(d, head);
+  d += head;
+  size -= head;
+
+  l4_umword_t *w = (l4_umword_t *)d;
+  for (; size >= 64; size -= 64)
+    for (unsigned i = 0; i < 64 / sizeof(l4_umword_t); ++i)
+      asm volatile ("movnti %1, %0" : "=m" (*w++) : "r" ((l4_umword_t)0));
+  asm volatile ("sfence" : : : "memory");
+
+  zero_rep_stosb((l4_uint8_t *)w, size);
+}
+#endif
+
+void
+bulk_zero(void *dst, size_t size)
+{
+  l4_uint8_t *d = (l4_uint8_t *)dst;
+
+#if defined(__aarch64__) || defined(__riscv)
+  size_t block = zero_block_size();
+  if (block && size >= 2 * block)
+    {
+      size_t head = -(l4_addr_t)d & (block - 1);
+      memset(d, 0, head);
+      d += head;
+      size -= head;
+
+      for (; size >= block; size -= block, d += block)
+        zero_block(d);
+    }
+#elif defined(__i386__) || defined(__x86_64__)
+  if (have_movnti && size >= Zero_nt_threshold)
+    {
+      zero_nt(d, size);
+      return;
+    }
+
+  if (bulk_copy_kernel == Bulk_copy_rep_movsb)
+    {
+      zero_rep_stosb(d, size);
+      return;
+    }
+#endif
+
+  memset(d, 0, size);
+}
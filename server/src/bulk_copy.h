@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <l4/sys/compiler.h>
+
+L4_BEGIN_DECLS
+
+/**
+ * Select the copy and zeroing kernels for the current CPU.
+ *
+ * Must be called once before the first bulk_move() / bulk_zero(). Until then
+ * the portable kernels are used.
+ */
+void bulk_copy_init(void);
+
+/**
+ * Copy large memory areas, e.g. boot modules and ELF segments.
+ *
+ * Source and destination may have any alignment and may overlap.
+ *
+ * \param dst   Destination address.
+ * \param src   Source address.
+ * \param size  Number of bytes to copy.
+ */
+void bulk_move(void *dst, void const *src, size_t size);
+
+/**
+ * Zero large memory areas, e.g. BSS segments or unused RAM.
+ *
+ * Uses cache-line zeroing (DC ZVA on arm64, cbo.zero on RISC-V if enabled
+ * with BOOTSTRAP_RISCV_CBO_ZERO) where the CPU and the current cache state
+ * permit, and ERMS / non-temporal stores on x86.
+ *
+ * \param dst   Destination address.
+ * \param size  Number of bytes to zero.
+ */
+void bulk_zero(void *dst, size_t size);
+
+#if defined(ARCH_riscv)
+/**
+ * Enable cbo.zero for bulk_zero().
+ *
+ * \param size  Zicboz block size common to all harts, 0 to disable.
+ */
+void bulk_zero_set_cbo_block_size(size_t size);
+#endif
+
+L4_END_DECLS
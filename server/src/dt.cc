@@ -13,8 +13,244 @@
 #include "region.h"
 
 #include "dt.h"
+#include "dt_summary.h"
 
-Dt::Parent_cache Dt::_parent_cache;
+Dt::Index Dt::_index;
+
+namespace {
+
+enum { Pool_size = 128 << 10 };
+
+l4_uint64_t pool[Pool_size / sizeof(l4_uint64_t)];
+unsigned long pool_used;
+
+}
+
+void *Dt::alloc(unsigned long size)
+{
+  size = (size + sizeof(pool[0]) - 1) & ~(sizeof(pool[0]) - 1);
+  if (size > sizeof(pool) - pool_used)
+    return nullptr;
+
+  void *p = reinterpret_cast<char *>(pool) + pool_used;
+  pool_used += size;
+  return p;
+}
+
+void Dt::Index::build(void const *fdt)
+{
+  unsigned num_nodes = 0;
+  unsigned num_phandles = 0;
+  unsigned num_compatibles = 0;
+  unsigned num_device_types = 0;
+  int max_depth = 0;
+  int depth = 0;
+  for (int node = fdt_next_node(fdt, -1, &depth);
+       node >= 0;
+       node = fdt_next_node(fdt, node, &depth))
+    {
+      ++num_nodes;
+      if (fdt_get_phandle(fdt, node))
+        ++num_phandles;
+      num_compatibles += cxx::max(fdt_stringlist_count(fdt, node, "compatible"),
+                                  0);
+      if (fdt_getprop(fdt, node, "device_type", nullptr))
+        ++num_device_types;
+      max_depth = cxx::max(max_depth, depth);
+    }
+
+  unsigned long pool_mark = pool_used;
+  _nodes = static_cast<Node_entry *>(alloc(sizeof(Node_entry) * num_nodes));
+  _phandles = static_cast<Phandle_entry *>(
+    alloc(sizeof(Phandle_entry) * num_phandles));
+  _compatibles = static_cast<Str_entry *>(
+    alloc(sizeof(Str_entry) * num_compatibles));
+  _device_types = static_cast<Str_entry *>(
+    alloc(sizeof(Str_entry) * num_device_types));
+  // Only needed while building the index
+  unsigned long stack_mark = pool_used;
+  int *stack = static_cast<int *>(alloc(sizeof(int) * (max_depth + 1)));
+  if (!_nodes || !_phandles || !_compatibles || !_device_types || !stack)
+    {
+      warn("Not enough memory to index %u nodes, lookups will be slow.\n",
+           num_nodes);
+      pool_used = pool_mark;
+      _nodes = nullptr;
+      _phandles = nullptr;
+      _compatibles = nullptr;
+      _device_types = nullptr;
+      return;
+    }
+
+  _num_nodes = 0;
+  _num_phandles = 0;
+  _num_compatibles = 0;
+  _num_device_types = 0;
+  depth = 0;
+  for (int node = fdt_next_node(fdt, -1, &depth);
+       node >= 0;
+       node = fdt_next_node(fdt, node, &depth))
+    {
+      stack[depth] = node;
+      _nodes[_num_nodes++] = Node_entry{node,
+                                        depth > 0 ? stack[depth - 1] : -1,
+                                        depth};
+
+      if (l4_uint32_t phandle = fdt_get_phandle(fdt, node))
+        {
+          // The phandles are usually assigned in ascending order
+          unsigned i = _num_phandles++;
+          for (; i > 0 && _phandles[i - 1].phandle > phandle; --i)
+            _phandles[i] = _phandles[i - 1];
+          _phandles[i] = Phandle_entry{phandle, node};
+        }
+
+      int len;
+      char const *c = static_cast<char const *>(
+        fdt_getprop(fdt, node, "compatible", &len));
+      for (char const *e = c ? c + len : c; c < e;)
+        {
+          // Only take complete strings, like fdt_stringlist_count()
+          auto *z = static_cast<char const *>(memchr(c, 0, e - c));
+          if (!z || _num_compatibles == num_compatibles)
+            break;
+          _compatibles[_num_compatibles++] = Str_entry{c, node};
+          c = z + 1;
+        }
+
+      if (char const *t = static_cast<char const *>(
+            fdt_getprop(fdt, node, "device_type", &len)))
+        if (len > 0 && !t[len - 1])
+          _device_types[_num_device_types++] = Str_entry{t, node};
+    }
+
+  sort(_compatibles, _num_compatibles);
+  sort(_device_types, _num_device_types);
+
+  pool_used = stack_mark;
+  _fdt = fdt;
+  info("Indexed %u nodes, %u phandles, %u compatibles, depth %d.\n",
+       _num_nodes, _num_phandles, _num_compatibles, max_depth);
+}
+
+/**
+ * Sort string entries by string and node offset.
+ *
+ * Heapsort, the index of big trees has thousands of entries.
+ */
+void Dt::Index::sort(Str_entry *entries, unsigned num)
+{
+  auto less = [](Str_entry const &a, Str_entry const &b)
+    {
+      int r = strcmp(a.str, b.str);
+      return r < 0 || (r == 0 && a.node < b.node);
+    };
+
+  auto sift_down = [&](unsigned root, unsigned end)
+    {
+      for (unsigned child; (child = 2 * root + 1) < end; root = child)
+        {
+          if (child + 1 < end && less(entries[child], entries[child + 1]))
+            ++child;
+          if (!less(entries[root], entries[child]))
+            return;
+          Str_entry t = entries[root];
+          entries[root] = entries[child];
+          entries[child] = t;
+        }
+    };
+
+  for (unsigned i = num / 2; i-- > 0;)
+    sift_down(i, num);
+
+  for (unsigned end = num; end > 1; --end)
+    {
+      Str_entry t = entries[0];
+      entries[0] = entries[end - 1];
+      entries[end - 1] = t;
+      sift_down(0, end - 1);
+    }
+}
+
+bool Dt::Index::find(void const *fdt, Str_entry const *entries, unsigned num,
+                     char const *str, Str_entry const **first,
+                     Str_entry const **last) const
+{
+  if (fdt != _fdt || !_nodes)
+    return false;
+
+  // Lower bound
+  unsigned min = 0;
+  unsigned max = num;
+  while (min < max)
+    {
+      unsigned idx = min + (max - min) / 2;
+      if (strcmp(entries[idx].str, str) < 0)
+        min = idx + 1;
+      else
+        max = idx;
+    }
+
+  *first = entries + min;
+  while (min < num && !strcmp(entries[min].str, str))
+    ++min;
+  *last = entries + min;
+  return true;
+}
+
+Dt::Index::Node_entry const *Dt::Index::find(void const *fdt, int node) const
+{
+  if (fdt != _fdt)
+    return nullptr;
+
+  unsigned min = 0;
+  unsigned max = _num_nodes;
+  while (min < max)
+    {
+      unsigned idx = min + (max - min) / 2;
+      if (_nodes[idx].node == node)
+        return &_nodes[idx];
+      else if (_nodes[idx].node > node)
+        max = idx;
+      else
+        min = idx + 1;
+    }
+
+  return nullptr;
+}
+
+int Dt::Index::parent(void const *fdt, int node) const
+{
+  Node_entry const *e = find(fdt, node);
+  return e ? e->parent : Unknown;
+}
+
+int Dt::Index::depth(void const *fdt, int node) const
+{
+  Node_entry const *e = find(fdt, node);
+  return e ? e->depth : Unknown;
+}
+
+int Dt::Index::node_by_phandle(void const *fdt, l4_uint32_t phandle) const
+{
+  if (fdt != _fdt)
+    return Unknown;
+
+  unsigned min = 0;
+  unsigned max = _num_phandles;
+  while (min < max)
+    {
+      unsigned idx = min + (max - min) / 2;
+      if (_phandles[idx].phandle == phandle)
+        return _phandles[idx].node;
+      else if (_phandles[idx].phandle > phandle)
+        max = idx;
+      else
+        min = idx + 1;
+    }
+
+  return -FDT_ERR_NOTFOUND;
+}
 
 void Dt::init(unsigned long fdt_addr)
 {
@@ -32,7 +268,9 @@ void Dt::init(unsigned long fdt_addr)
       return;
     }
 
-  Dt::_parent_cache.scan(_fdt);
+  // The pool only holds the index of the current device tree
+  pool_used = 0;
+  _index.build(_fdt);
 }
 
 void Dt::check_for_dt() const
@@ -48,11 +286,18 @@ Dt::Node Dt::node_by_path(char const *path, int namelen) const
 
 Dt::Node Dt::node_by_phandle(uint32_t phandle) const
 {
-  return Node(_fdt, fdt_node_offset_by_phandle(_fdt, phandle));
+  int node = _index.node_by_phandle(_fdt, phandle);
+  if (node == Index::Unknown)
+    node = fdt_node_offset_by_phandle(_fdt, phandle);
+  return Node(_fdt, node);
 }
 
 Dt::Node Dt::node_by_compatible(char const *compatible) const
 {
+  Index::Str_entry const *first, *last;
+  if (_index.find_compatible(_fdt, compatible, &first, &last))
+    return Node(_fdt, first != last ? first->node : -FDT_ERR_NOTFOUND);
+
   return Node(_fdt, fdt_node_offset_by_compatible(_fdt, -1, compatible));
 }
 
@@ -195,7 +440,7 @@ Dt::Node Dt::get_clock(Node node, char const *name, int index) const
 void Dt::setup_memory() const
 {
   // Iterate all memory nodes
-  nodes_by_prop_value("device_type", "memory", 7, [](Dt::Node mem)
+  nodes_by_device_type("memory", [](Dt::Node mem)
     {
       // One example for this is 'secram' with 'status = "disabled' and
       // secure-status = "okay".
@@ -306,6 +551,344 @@ l4_uint64_t Dt::cpu_release_addr() const
   return cpu_release_addr;
 }
 
+Dt::Node Dt::interrupt_parent(Node node) const
+{
+  for (; node.is_valid(); node = node.parent_node())
+    {
+      l4_uint32_t phandle;
+      if (node.get_prop_u32("interrupt-parent", phandle))
+        return node_by_phandle(phandle);
+    }
+
+  return Node();
+}
+
+namespace {
+
+Dt_summary::Irq_parent summary_irq_parent(Dt::Node intc)
+{
+  Dt_summary::Irq_parent p{0, 0};
+  if (intc.is_valid())
+    {
+      p.phandle = intc.phandle();
+      intc.get_prop_u32("#interrupt-cells", p.interrupt_cells);
+    }
+  return p;
+}
+
+}
+
+unsigned long Dt::write_summary(void *buf, unsigned long size,
+                                L4_kernel_options::Uart const &kuart,
+                                unsigned kuart_flags) const
+{
+  using namespace Dt_summary;
+
+  unsigned num_mem = 0;
+  for (auto const &r: *mem_manager->ram)
+    {
+      (void)r;
+      ++num_mem;
+    }
+
+  unsigned num_rsv = fdt_num_mem_rsv(_fdt) > 0 ? fdt_num_mem_rsv(_fdt) : 0;
+  Node rsrv_mem = node_by_path("/reserved-memory");
+  if (rsrv_mem.is_valid())
+    rsrv_mem.for_each_subnode([&](Node rsrv)
+      {
+        if (rsrv.is_enabled())
+          rsrv.for_each_reg([&](l4_uint64_t, l4_uint64_t) { ++num_rsv; });
+      });
+
+  unsigned num_cpus = 0;
+  Node cpus = node_by_path("/cpus");
+  if (cpus.is_valid())
+    cpus.for_each_subnode([&](Node cpu)
+      {
+        if (cpu.check_device_type("cpu"))
+          ++num_cpus;
+      });
+
+  unsigned long need = sizeof(Header) + sizeof(Mem) * (num_mem + num_rsv)
+                       + sizeof(Cpu) * num_cpus;
+  if (!buf || need > size)
+    return need;
+
+  auto *h = static_cast<Header *>(buf);
+  memset(h, 0, need);
+  h->magic = Magic;
+  h->version = Version;
+  h->size = need;
+  h->header_size = sizeof(Header);
+  h->mem_size = sizeof(Mem);
+  h->cpu_size = sizeof(Cpu);
+  h->mem_offset = sizeof(Header);
+  h->rsv_offset = h->mem_offset + sizeof(Mem) * num_mem;
+  h->cpu_offset = h->rsv_offset + sizeof(Mem) * num_rsv;
+
+  auto *mem = reinterpret_cast<Mem *>(static_cast<char *>(buf) + h->mem_offset);
+  for (auto const &r: *mem_manager->ram)
+    mem[h->num_mem++] = Mem{r.begin(), r.size()};
+
+  auto *rsv = reinterpret_cast<Mem *>(static_cast<char *>(buf) + h->rsv_offset);
+  for (int n = 0; n < fdt_num_mem_rsv(_fdt); ++n)
+    {
+      uint64_t addr, sz;
+      if (!fdt_get_mem_rsv(_fdt, n, &addr, &sz))
+        rsv[h->num_rsv++] = Mem{addr, sz};
+    }
+  if (rsrv_mem.is_valid())
+    rsrv_mem.for_each_subnode([&](Node r)
+      {
+        if (r.is_enabled())
+          r.for_each_reg([&](l4_uint64_t start, l4_uint64_t sz)
+            { rsv[h->num_rsv++] = Mem{start, sz}; });
+      });
+
+  auto *cpu = reinterpret_cast<Cpu *>(static_cast<char *>(buf) + h->cpu_offset);
+  unsigned addr_cells, size_cells;
+  if (cpus.is_valid() && cpus.get_addr_size_cells(addr_cells, size_cells))
+    cpus.for_each_subnode([&](Node c)
+      {
+        if (!c.check_device_type("cpu"))
+          return;
+
+        Cpu *e = &cpu[h->num_cpus++];
+        // The reg property of CPUs cannot be translated, read it directly
+        auto reg = c.get_prop_array("reg", { addr_cells });
+        e->hwid = reg.is_valid() && reg.elements() ? reg.get(0, 0) : ~0ULL;
+        e->release_addr = ~0ULL;
+        c.get_prop_u64("cpu-release-addr", e->release_addr);
+        if (c.stringlist_contains("enable-method", "psci"))
+          e->enable_method = Enable_psci;
+        else if (c.stringlist_contains("enable-method", "spin-table"))
+          e->enable_method = Enable_spin_table;
+        else if (c.has_prop("enable-method"))
+          e->enable_method = Enable_other;
+        else
+          e->enable_method = Enable_none;
+        if (c.is_enabled())
+          e->flags |= Cpu_enabled;
+
+        Node intc;
+        c.for_each_subnode([&](Node sub)
+          {
+            if (!sub.has_prop("interrupt-controller"))
+              return Continue;
+            intc = sub;
+            return Break;
+          });
+        if (!intc.is_valid())
+          intc = interrupt_parent(c);
+        e->irq_parent = summary_irq_parent(intc);
+      });
+
+  if (kuart_flags & L4_kernel_options::F_uart_base)
+    {
+      h->uart.valid = 1;
+      h->uart.base_address = kuart.base_address;
+      h->uart.base_baud = kuart.base_baud;
+      h->uart.baud = kuart.baud;
+      h->uart.irqno = kuart_flags & L4_kernel_options::F_uart_irq
+                      ? kuart.irqno : ~0U;
+      h->uart.reg_shift = kuart.reg_shift;
+      h->uart.access_type = kuart.access_type;
+      memcpy(h->uart.compatible_id, kuart.compatible_id,
+             sizeof(h->uart.compatible_id));
+
+      unsigned long baud;
+      Node uart = get_stdout_uart_node(&baud);
+      if (uart.is_valid())
+        h->uart_irq_parent = summary_irq_parent(interrupt_parent(uart));
+    }
+
+  return need;
+}
+
+namespace {
+
+/// FNV-1a hash of a property name
+l4_uint32_t name_hash(char const *s)
+{
+  l4_uint32_t h = 2166136261U;
+  for (; *s; ++s)
+    h = (h ^ static_cast<unsigned char>(*s)) * 16777619U;
+  return h;
+}
+
+/// Number of slots of the property name hash table used by Dt::compact().
+unsigned long name_slots(void const *fdt)
+{
+  char const *s = static_cast<char const *>(fdt) + fdt_off_dt_strings(fdt);
+  unsigned long names = 0;
+  for (unsigned long i = 0; i < fdt_size_dt_strings(fdt); ++i)
+    if (!s[i])
+      ++names;
+
+  unsigned long slots = 16;
+  while (slots < 2 * names)
+    slots <<= 1;
+  return slots;
+}
+
+}
+
+unsigned long Dt::compact_buffer_size() const
+{
+  unsigned long size = (fdt_size() + 7) & ~7UL;
+  return size + name_slots(_fdt) * sizeof(l4_uint32_t);
+}
+
+unsigned long Dt::compact(void *buf, unsigned long size) const
+{
+  if (fdt_version(_fdt) < 17)
+    {
+      warn("Cannot compact version %u device tree.\n", fdt_version(_fdt));
+      return 0;
+    }
+
+  if (size < compact_buffer_size())
+    return 0;
+
+  enum { Max_prune = 16 };
+  int prune[Max_prune];
+  unsigned num_prune = 0;
+  Node chosen = node_by_path("/chosen");
+  if (chosen.is_valid())
+    chosen.stringlist_for_each("l4re,dt-prune", [&](int, char const *path)
+      {
+        int node = fdt_path_offset(_fdt, path);
+        if (node <= 0)
+          warn("Cannot prune '%s'.\n", path);
+        else if (num_prune == Max_prune)
+          warn("Too many nodes to prune, ignoring '%s'.\n", path);
+        else
+          prune[num_prune++] = node;
+      });
+
+  auto pruned = [&](int node)
+    {
+      for (unsigned i = 0; i < num_prune; ++i)
+        if (prune[i] == node)
+          return true;
+
+      if (Node(_fdt, node).is_enabled())
+        return false;
+
+      // Disabled nodes referenced by phandle, also those of subnodes, might
+      // still be needed by their users. Disabled CPUs can be brought online
+      // later.
+      int depth = 0;
+      int n = node;
+      do
+        if (fdt_get_phandle(_fdt, n) || Node(_fdt, n).check_device_type("cpu"))
+          return false;
+      while ((n = fdt_next_node(_fdt, n, &depth)) >= 0 && depth > 0);
+
+      return true;
+    };
+
+  char *dst = static_cast<char *>(buf);
+  char const *src = static_cast<char const *>(_fdt);
+
+  unsigned long rsv_size = (cxx::max(fdt_num_mem_rsv(_fdt), 0) + 1)
+                           * sizeof(fdt_reserve_entry);
+  unsigned long off_rsv = sizeof(fdt_header);
+  unsigned long off_struct = off_rsv + rsv_size;
+  memcpy(dst + off_rsv, src + fdt_off_mem_rsvmap(_fdt), rsv_size);
+
+  // The new strings block is collected behind the space of the old structure
+  // block and moved in place at the end. The new blocks are never larger than
+  // the old ones.
+  char *strings = dst + off_struct + fdt_size_dt_struct(_fdt);
+  unsigned long strings_size = 0;
+  unsigned long slots = name_slots(_fdt);
+  l4_uint32_t *names = reinterpret_cast<l4_uint32_t *>(
+    dst + ((fdt_size() + 7) & ~7UL));
+  memset(names, 0, slots * sizeof(*names));
+
+  // Offset of the name in the new strings block, add it if not yet present.
+  auto name_offset = [&](char const *name)
+    {
+      unsigned long i = name_hash(name) & (slots - 1);
+      for (; names[i]; i = (i + 1) & (slots - 1))
+        if (!strcmp(strings + names[i] - 1, name))
+          return names[i] - 1;
+
+      unsigned long len = strlen(name) + 1;
+      memcpy(strings + strings_size, name, len);
+      names[i] = strings_size + 1;
+      strings_size += len;
+      return names[i] - 1;
+    };
+
+  unsigned long struct_size = 0;
+  unsigned removed = 0;
+  int next;
+  for (int off = 0;; off = next)
+    {
+      l4_uint32_t tag = fdt_next_tag(_fdt, off, &next);
+      if (next < 0)
+        {
+          warn("Cannot compact device tree: %s\n", fdt_strerror(next));
+          return 0;
+        }
+
+      if (tag == FDT_NOP)
+        continue;
+
+      if (tag == FDT_BEGIN_NODE && off > 0 && pruned(off))
+        {
+          // Skip the node including its subnodes
+          ++removed;
+          for (int depth = 1; depth > 0 && next >= 0;)
+            {
+              tag = fdt_next_tag(_fdt, next, &next);
+              if (tag == FDT_BEGIN_NODE)
+                ++depth;
+              else if (tag == FDT_END_NODE)
+                --depth;
+            }
+          continue;
+        }
+
+      memcpy(dst + off_struct + struct_size, src + fdt_off_dt_struct(_fdt) + off,
+             next - off);
+      if (tag == FDT_PROP)
+        {
+          char const *name;
+          fdt_getprop_by_offset(_fdt, off, &name, nullptr);
+          auto *p = reinterpret_cast<fdt_property *>(dst + off_struct
+                                                     + struct_size);
+          p->nameoff = cpu_to_fdt32(name_offset(name));
+        }
+
+      struct_size += next - off;
+      if (tag == FDT_END)
+        break;
+    }
+
+  unsigned long off_strings = off_struct + struct_size;
+  memmove(dst + off_strings, strings, strings_size);
+
+  fdt_header *h = reinterpret_cast<fdt_header *>(dst);
+  memset(h, 0, sizeof(*h));
+  fdt_set_magic(h, FDT_MAGIC);
+  fdt_set_totalsize(h, off_strings + strings_size);
+  fdt_set_off_dt_struct(h, off_struct);
+  fdt_set_off_dt_strings(h, off_strings);
+  fdt_set_off_mem_rsvmap(h, off_rsv);
+  fdt_set_version(h, 17);
+  fdt_set_last_comp_version(h, 16);
+  fdt_set_boot_cpuid_phys(h, fdt_boot_cpuid_phys(_fdt));
+  fdt_set_size_dt_strings(h, strings_size);
+  fdt_set_size_dt_struct(h, struct_size);
+
+  info("Compacted: %u -> %lu bytes, %u nodes pruned\n",
+       fdt_size(), off_strings + strings_size, removed);
+  return off_strings + strings_size;
+}
+
 Dt::Node Dt::get_stdout_uart_node(unsigned long *baud) const
 {
   Node chosen = node_by_path("/chosen");
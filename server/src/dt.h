@@ -180,66 +180,96 @@ public:
     }
   };
 
-  class Parent_cache
+  /**
+   * Index of the nodes of a flattened device tree.
+   *
+   * Built once in Dt::init() and sized to the number of nodes of the blob.
+   * Provides parent, depth, phandle, compatible and device_type lookups with
+   * binary search instead of walking the flattened tree. If the index could
+   * not be built, the lookups fail and the callers fall back to libfdt.
+   */
+  class Index
   {
   public:
-    struct Cache_elem
+    enum { Unknown = -2 };
+
+    /// A string of a node property, the string points into the blob.
+    struct Str_entry
     {
+      char const *str;
       int node;
-      int parent;
     };
 
-    void scan(const void *fdt)
-    {
-      enum { Stack_len = 16 };
-      int parent_stack[Stack_len];
-      int depth = 0;
-      for (int node = fdt_next_node(fdt, -1, &depth);
-           node >= 0;
-           node = fdt_next_node(fdt, node, &depth))
-        {
-          int parent = depth > 0 && depth <= Stack_len
-                       ? parent_stack[depth - 1] : -1;
-          if (_num_elems < Max_num_elems)
-            {
-              if (depth < Stack_len)
-                {
-                  _cache[_num_elems].node   = node;
-                  _cache[_num_elems].parent = parent;
-                  parent_stack[depth] = node;
-                  ++_num_elems;
-                }
-            }
-          else
-            break;
-        }
-    }
+    void build(void const *fdt);
 
-    int get_parent(int node)
-    {
-      int min = 0;
-      int max = _num_elems - 1;
-      while (max >= min)
-        {
-          int idx = min + ((max - min) / 2);
-
-          if (_cache[idx].node == node)
-            return _cache[idx].parent;
-          else if (_cache[idx].node > node)
-            max = idx - 1;
-          else // _cache[idx].node < node
-            min = idx + 1;
-        }
+    /**
+     * Get the parent of a node.
+     *
+     * \retval >= 0     Offset of the parent node.
+     * \retval -1       The node is the root node.
+     * \retval Unknown  The node is not in the index.
+     */
+    int parent(void const *fdt, int node) const;
 
-      return -1;
-    }
+    /// Depth of a node, the root node has depth 0, Unknown if not indexed.
+    int depth(void const *fdt, int node) const;
+
+    /// Offset of the node with the given phandle, Unknown if not indexed.
+    int node_by_phandle(void const *fdt, l4_uint32_t phandle) const;
+
+    /**
+     * Find the nodes compatible with a string.
+     *
+     * \param      fdt         Device tree blob.
+     * \param      compatible  Compatible string.
+     * \param[out] first       First matching entry.
+     * \param[out] last        Entry after the last match.
+     *
+     * \retval true   Matches, if any, are in [first, last) in tree order.
+     * \retval false  The device tree is not indexed.
+     */
+    bool find_compatible(void const *fdt, char const *compatible,
+                         Str_entry const **first, Str_entry const **last) const
+    { return find(fdt, _compatibles, _num_compatibles, compatible, first, last); }
+
+    /// Like find_compatible() but for the device_type property.
+    bool find_device_type(void const *fdt, char const *device_type,
+                          Str_entry const **first, Str_entry const **last) const
+    { return find(fdt, _device_types, _num_device_types, device_type, first, last); }
 
   private:
-    enum { Max_num_elems = 1024 };
-    /// Cached node->parent mappings, sorted by ascending offset,
-    /// which enables get_parent() to use binary search.
-    Cache_elem _cache[Max_num_elems];
-    int _num_elems = 0;
+    struct Node_entry
+    {
+      int node;
+      int parent;
+      int depth;
+    };
+
+    struct Phandle_entry
+    {
+      l4_uint32_t phandle;
+      int node;
+    };
+
+    Node_entry const *find(void const *fdt, int node) const;
+    bool find(void const *fdt, Str_entry const *entries, unsigned num,
+              char const *str, Str_entry const **first,
+              Str_entry const **last) const;
+    static void sort(Str_entry *entries, unsigned num);
+
+    void const *_fdt = nullptr;
+    /// All nodes sorted by ascending offset
+    Node_entry *_nodes = nullptr;
+    unsigned _num_nodes = 0;
+    /// All nodes with a phandle sorted by ascending phandle
+    Phandle_entry *_phandles = nullptr;
+    unsigned _num_phandles = 0;
+    /// All compatible strings sorted by string and node offset
+    Str_entry *_compatibles = nullptr;
+    unsigned _num_compatibles = 0;
+    /// All device_type values sorted by string and node offset
+    Str_entry *_device_types = nullptr;
+    unsigned _num_device_types = 0;
   };
 
   class Node
@@ -254,17 +284,26 @@ public:
     bool is_root_node() const
     { return _off == 0; }
 
+    /// Phandle of the node, 0 if it has none.
+    l4_uint32_t phandle() const
+    { return fdt_get_phandle(_fdt, _off); }
+
     Node parent_node() const
     {
-      int parent = _parent_cache.get_parent(_off);
-      if (parent == -1)
-        {
-          warn("parent_node() cache-miss, consider increasing cache.\n");
-          return Node(_fdt, fdt_parent_offset(_fdt, _off));
-        }
+      int parent = _index.parent(_fdt, _off);
+      if (parent == Index::Unknown)
+        return Node(_fdt, fdt_parent_offset(_fdt, _off));
       return Node(_fdt, parent);
     }
 
+    int depth() const
+    {
+      int depth = _index.depth(_fdt, _off);
+      if (depth == Index::Unknown)
+        return fdt_node_depth(_fdt, _off);
+      return depth;
+    }
+
     char const *get_name(char const *default_name = nullptr) const
     {
       if (is_root_node())
@@ -537,10 +576,35 @@ public:
   template<typename CB>
   void nodes_by_compatible(char const *compatible, CB &&cb) const
   {
+    Index::Str_entry const *e, *last;
+    if (_index.find_compatible(_fdt, compatible, &e, &last))
+      {
+        for (; e != last; ++e)
+          if (invoke_cb(cb, Node(_fdt, e->node)) == Break)
+            return;
+        return;
+      }
+
     nodes_by(cb, [this, compatible](int node)
       { return fdt_node_offset_by_compatible(_fdt, node, compatible); });
   }
 
+  template<typename CB>
+  void nodes_by_device_type(char const *device_type, CB &&cb) const
+  {
+    Index::Str_entry const *e, *last;
+    if (_index.find_device_type(_fdt, device_type, &e, &last))
+      {
+        for (; e != last; ++e)
+          if (invoke_cb(cb, Node(_fdt, e->node)) == Break)
+            return;
+        return;
+      }
+
+    nodes_by_prop_value("device_type", device_type, strlen(device_type) + 1,
+                        cb);
+  }
+
   template<typename T = l4_uint64_t>
   static T read_value(fdt32_t const *cells, unsigned size)
   {
@@ -558,6 +622,37 @@ public:
   void setup_memory() const;
   l4_uint64_t cpu_release_addr() const;
 
+  /**
+   * Write the platform summary, see Dt_summary.
+   *
+   * \param buf          Destination, may be nullptr to query the size.
+   * \param size         Size of `buf`.
+   * \param kuart        Console UART.
+   * \param kuart_flags  Flags of the console UART.
+   *
+   * \return Size of the summary. Nothing is written if larger than `size`.
+   */
+  unsigned long write_summary(void *buf, unsigned long size,
+                              L4_kernel_options::Uart const &kuart,
+                              unsigned kuart_flags) const;
+
+  /// Size of the buffer needed by compact().
+  unsigned long compact_buffer_size() const;
+
+  /**
+   * Write a compacted copy of the device tree.
+   *
+   * Leaves out disabled nodes unless they are CPUs or referenced by phandle,
+   * and the nodes listed in the "l4re,dt-prune" property of /chosen. The
+   * strings block is deduplicated, NOPs and free space are dropped.
+   *
+   * \param buf   Destination, also used as scratch space.
+   * \param size  Size of `buf`, at least compact_buffer_size().
+   *
+   * \return Size of the compacted device tree, 0 on failure.
+   */
+  unsigned long compact(void *buf, unsigned long size) const;
+
   /**
    * Get the clock with the given name or index for the given node.
    *
@@ -570,6 +665,16 @@ public:
    */
   Node get_clock(Node node, char const *name, int index) const;
 
+  /**
+   * Get the interrupt parent of a node.
+   *
+   * The "interrupt-parent" property is inherited from the ancestors of the
+   * node.
+   *
+   * \return Interrupt controller node, or invalid node if there is none.
+   */
+  Node interrupt_parent(Node node) const;
+
   /// Function that translates "interrupts" property into IRQ number.
   using Parse_irq_fn = int (*)(Node);
 
@@ -659,7 +764,17 @@ protected:
 
   void const *_fdt = nullptr;
 
+  /**
+   * Allocate memory for indexes of the device tree.
+   *
+   * The RAM layout is only known after parsing the device tree, therefore
+   * the memory comes from a static pool.
+   *
+   * \return Memory, nullptr if the pool is exhausted.
+   */
+  static void *alloc(unsigned long size);
+
 public:
-  static Parent_cache _parent_cache;
+  static Index _index;
 };
 
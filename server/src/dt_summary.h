@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include <l4/sys/l4int.h>
+
+/**
+ * Layout of the ".platsum" module.
+ *
+ * Summary of the platform information bootstrap extracted from the device
+ * tree, handed over next to the ".fdt" module so that later stages do not
+ * need to walk the device tree for the memory, CPU and console topology.
+ *
+ * The header is followed by the tables at the given offsets. Consumers must
+ * check the magic and version, and use `*_size` as the stride of the tables
+ * so that entries can be extended in later versions.
+ */
+namespace Dt_summary {
+
+enum : l4_uint32_t
+{
+  Magic   = 0x4d555350, ///< "PSUM" on little-endian machines
+  Version = 1,
+};
+
+enum Enable_method : l4_uint32_t
+{
+  Enable_none       = 0,
+  Enable_psci       = 1,
+  Enable_spin_table = 2,
+  Enable_other      = 3,
+};
+
+enum Cpu_flags : l4_uint32_t
+{
+  Cpu_enabled = 1 << 0, ///< The status property of the CPU is "okay"
+};
+
+/// Interrupt controller a device or CPU is connected to
+struct Irq_parent
+{
+  l4_uint32_t phandle;         ///< 0 if none
+  l4_uint32_t interrupt_cells; ///< #interrupt-cells of the controller
+};
+
+struct Mem
+{
+  l4_uint64_t start;
+  l4_uint64_t size;
+};
+
+struct Cpu
+{
+  l4_uint64_t hwid;          ///< First reg entry, e.g. MPIDR or hart ID
+  l4_uint64_t release_addr;  ///< cpu-release-addr for spin-table, else ~0
+  l4_uint32_t enable_method; ///< See Enable_method
+  l4_uint32_t flags;         ///< See Cpu_flags
+  /// Per-CPU interrupt controller (e.g. RISC-V hart-local), else the
+  /// interrupt parent of the CPU node
+  Irq_parent  irq_parent;
+};
+
+struct Uart
+{
+  l4_uint64_t base_address;
+  l4_uint32_t base_baud;
+  l4_uint32_t baud;
+  l4_uint32_t irqno;         ///< ~0 if none
+  l4_uint8_t  reg_shift;
+  l4_uint8_t  access_type;   ///< L4_kernel_options::Uart_type
+  l4_uint8_t  valid;
+  l4_uint8_t  _pad;
+  char        compatible_id[32];
+};
+
+struct Header
+{
+  l4_uint32_t magic;
+  l4_uint32_t version;
+  l4_uint32_t size;          ///< Size of the summary including all tables
+  l4_uint32_t header_size;
+
+  l4_uint32_t mem_offset;    ///< RAM regions, as used for the kernel
+  l4_uint32_t num_mem;
+  l4_uint32_t rsv_offset;    ///< Reserved memory and /memreserve/ ranges
+  l4_uint32_t num_rsv;
+  l4_uint32_t cpu_offset;    ///< CPU nodes below /cpus
+  l4_uint32_t num_cpus;
+  l4_uint32_t mem_size;      ///< sizeof(Mem)
+  l4_uint32_t cpu_size;      ///< sizeof(Cpu)
+
+  Uart        uart;          ///< Console UART
+  Irq_parent  uart_irq_parent;
+};
+
+}
@@ -8,10 +8,12 @@
 
 #include <l4/drivers/uart_base.h>
 #include <l4/sys/types.h>
+#include <l4/util/elf.h>
 #include <l4/util/mb_info.h>
 #include "efi-support.h"
 #include "memory.h"
 #include "panic.h"
+#include "startup.h"
 
 #if defined(ARCH_x86) || defined(ARCH_amd64)
 #include <l4/util/irq.h> // l4util_cli
@@ -453,3 +455,234 @@ void Efi::setup_gop()
 }
 
 Efi efi;
+
+/**
+ * Open a file on the boot volume.
+ *
+ * \param name  Path of the file, '/' and '\' are both accepted as separator.
+ *
+ * \return File handle or nullptr if the file does not exist.
+ */
+EFI_FILE_HANDLE
+Boot_modules_efi::open(char const *name)
+{
+  CHAR16 path[256];
+  unsigned i;
+  for (i = 0; name[i] && i < sizeof(path) / sizeof(path[0]) - 1; ++i)
+    path[i] = name[i] == '/' ? L'\\' : name[i];
+  path[i] = 0;
+
+  if (name[i])
+    panic("EFI: Path too long: %s", name);
+
+  EFI_FILE_HANDLE f;
+  EFI_STATUS r = uefi_call_wrapper(_root->Open, 5, _root, &f, path,
+                                   EFI_FILE_MODE_READ, 0);
+  return r == EFI_SUCCESS ? f : nullptr;
+}
+
+bool
+Boot_modules_efi::probe()
+{
+  if (_probed)
+    return _num_mods > 0;
+
+  _probed = true;
+
+  EFI_LOADED_IMAGE *li;
+  EFI_STATUS r = uefi_call_wrapper(BS->HandleProtocol, 3, efi.image(),
+                                   &LoadedImageProtocol, (void **)&li);
+  if (r != EFI_SUCCESS)
+    return false;
+
+  _root = LibOpenRoot(li->DeviceHandle);
+  if (!_root)
+    return false;
+
+  EFI_FILE_HANDLE f = open("/l4re/modules.list");
+  if (!f)
+    return false;
+
+  UINTN size = sizeof(_list) - 1;
+  r = uefi_call_wrapper(f->Read, 3, f, &size, _list);
+  uefi_call_wrapper(f->Close, 1, f);
+  if (r != EFI_SUCCESS)
+    panic("EFI: Could not read module list: %u", (unsigned)r);
+
+  if (size == sizeof(_list) - 1)
+    panic("EFI: Module list too large.");
+
+  _list[size] = 0;
+
+  parse_list();
+
+  for (unsigned i = 0; i < _num_mods; ++i)
+    {
+      f = open(_mods[i].name);
+      if (!f)
+        panic("EFI: Module '%s' not found.", _mods[i].name);
+
+      EFI_FILE_INFO *info = LibFileInfo(f);
+      uefi_call_wrapper(f->Close, 1, f);
+      if (!info)
+        panic("EFI: Could not get size of module '%s'.", _mods[i].name);
+
+      _mods[i].size = info->FileSize;
+      FreePool(info);
+
+      if (_mods[i].size == 0)
+        panic("EFI: Module '%s' empty, modules must not have zero size.",
+              _mods[i].name);
+    }
+
+  if (_num_mods)
+    log_info("  Using %u modules from the EFI boot volume.\n", _num_mods);
+
+  return _num_mods > 0;
+}
+
+/**
+ * Read a module from the boot volume and reserve the memory.
+ *
+ * The destination is allocated from the firmware first so that the read
+ * cannot clobber memory still used by the boot services. The remaining bytes
+ * of the last page are filled with zeros.
+ */
+void
+Boot_modules_efi::load(unsigned index, Region::Type type)
+{
+  enum { Chunk_size = 32 << 20 };
+
+  Mod const &m = _mods[index];
+  unsigned long size = l4_round_page(m.size);
+
+  // Our view of free RAM includes memory used by the boot services. Only
+  // consider memory the firmware currently reports as conventional memory.
+  UINTN num_entries, key, desc_size;
+  uint32_t desc_ver;
+  EFI_MEMORY_DESCRIPTOR *efi_mem_desc = LibMemoryMap(&num_entries, &key,
+                                                     &desc_size, &desc_ver);
+  if (!efi_mem_desc)
+    panic("EFI: failed to get memory map");
+
+  EFI_PHYSICAL_ADDRESS addr = 0;
+  void *const map_end = (char *)efi_mem_desc + num_entries * desc_size;
+  for (char *d = (char *)efi_mem_desc; d < map_end; d += desc_size)
+    {
+      EFI_MEMORY_DESCRIPTOR *md = (EFI_MEMORY_DESCRIPTOR *)d;
+      if (md->Type != EfiConventionalMemory || !md->NumberOfPages
+          || md->PhysicalStart > mem_end)
+        continue;
+
+      Region area = Region::start_size(md->PhysicalStart,
+                                       0x1000 * md->NumberOfPages,
+                                       "ram for modules");
+      if (area.end() > mem_end)
+        area.end(mem_end);
+
+      // Allocate from the top of RAM
+      unsigned long a = mem_manager->regions->find_free_rev(area, size,
+                                                            L4_PAGESHIFT);
+      if (a > addr)
+        addr = a;
+    }
+
+  FreePool(efi_mem_desc);
+
+  if (!addr)
+    panic("EFI: Could not allocate %lu bytes for module '%s'.",
+          size, m.name);
+
+  EFI_STATUS r = uefi_call_wrapper(BS->AllocatePages, 4, AllocateAddress,
+                                   EfiLoaderData, size >> L4_PAGESHIFT, &addr);
+  if (r != EFI_SUCCESS)
+    panic("EFI: AllocatePages for module '%s' failed: %u",
+          m.name, (unsigned)r);
+
+  log_verbose("  EFI: Loading module %02u to %llx (%lu bytes): %s\n",
+              index, (unsigned long long)addr, m.size, m.cmdline);
+
+  EFI_FILE_HANDLE f = open(m.name);
+  if (!f)
+    panic("EFI: Module '%s' not found.", m.name);
+
+  char *dest = reinterpret_cast<char *>(static_cast<l4_addr_t>(addr));
+  for (unsigned long offs = 0; offs < m.size;)
+    {
+      UINTN chunk = m.size - offs;
+      if (chunk > Chunk_size)
+        chunk = Chunk_size;
+
+      EFI_STATUS r = uefi_call_wrapper(f->Read, 3, f, &chunk, dest + offs);
+      if (r != EFI_SUCCESS || chunk == 0)
+        panic("EFI: Could not read module '%s': %u", m.name, (unsigned)r);
+
+      offs += chunk;
+    }
+
+  uefi_call_wrapper(f->Close, 1, f);
+  memset(dest + m.size, 0, size - m.size);
+
+  add_region(index, addr, m.size, type);
+}
+
+void
+Boot_modules_efi::reserve_load_range(unsigned index)
+{
+  static char hdr[L4_PAGESIZE];
+
+  Mod const &m = _mods[index];
+  EFI_FILE_HANDLE f = open(m.name);
+  if (!f)
+    return; // load() reports the missing module
+
+  UINTN size = sizeof(hdr);
+  EFI_STATUS r = uefi_call_wrapper(f->Read, 3, f, &size, hdr);
+  uefi_call_wrapper(f->Close, 1, f);
+
+  auto const *eh = reinterpret_cast<ElfW(Ehdr) const *>(hdr);
+  if (r != EFI_SUCCESS || size < sizeof(*eh)
+      || !l4util_elf_check_magic(eh) || !l4util_elf_check_arch(eh))
+    return;
+
+  if (eh->e_phoff + eh->e_phnum * eh->e_phentsize > size)
+    {
+      log_warn("EFI: Program headers of '%s' not at the start of the file.\n",
+               m.name);
+      return;
+    }
+
+  for (unsigned i = 0; i < eh->e_phnum; ++i)
+    {
+      auto const *ph = reinterpret_cast<ElfW(Phdr) const *>(
+        hdr + eh->e_phoff + i * eh->e_phentsize);
+      if (ph->p_type == PT_LOAD && ph->p_memsz)
+        mem_manager->regions->add(
+          Region::start_size(ph->p_paddr, ph->p_memsz, ".elf-load",
+                             Region::Boot, Region::Boot_temporary),
+          true);
+    }
+}
+
+void
+Boot_modules_efi::init_mod_regions()
+{
+  // The ELF regions of the kernel, sigma0 and the root task are only added
+  // when they are loaded. Keep their load addresses free while placing the
+  // modules, the regions are ignored by the overlap check later.
+  for (unsigned i = 0; i < _num_mods && i < Num_base_mods; ++i)
+    reserve_load_range(i);
+
+  // The kernel, sigma0 and the root task are only needed until their ELF
+  // regions are loaded. The modules are allocated from the top of RAM, away
+  // from the usual link addresses.
+  for (unsigned i = 0; i < _num_mods; ++i)
+    load(i, i < Num_base_mods ? Region::Boot : Region::Root);
+}
+
+l4util_l4mod_info *
+Boot_modules_efi::construct_mbi(unsigned long mod_addr,
+                                Internal_module_list const &internal_mods)
+{
+  return efi.construct_mbi(build_mbi(mod_addr, internal_mods));
+}
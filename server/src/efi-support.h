@@ -11,6 +11,7 @@ extern "C" {
 #include <efilib.h>
 }
 
+#include "boot_modules.h"
 #include "support.h"
 
 class Efi
@@ -24,6 +25,7 @@ public:
   void exit_boot_services();
   void firmware_announce_memory(Region);
 
+  EFI_HANDLE image() const { return _image; }
   EFI_SYSTEM_TABLE *system_table() const { return _sys_table; }
   void *acpi_rsdp() const { return _acpi_rsdp; }
   void disable_acpi() { _acpi_rsdp = nullptr; }
@@ -45,3 +47,49 @@ private:
 };
 
 extern Efi efi;
+
+/**
+ * Boot modules read from the file system bootstrap was loaded from.
+ *
+ * The file `/l4re/modules.list` on the boot volume lists one module per
+ * line: the path of the module file, relative to the root of the volume,
+ * followed by the command line of the module. For example:
+ *
+ *     /l4re/fiasco fiasco -serial_esc
+ *     /l4re/sigma0 sigma0
+ *     /l4re/moe moe rom/hello.cfg
+ *     /l4re/hello.cfg rom/hello.cfg
+ *
+ * Each module is read directly to its final location, so the modules linked
+ * into the bootstrap image are not needed. All modules are read when the
+ * regions are initialized because the boot services are gone afterwards.
+ *
+ * The modules are placed at the top of RAM before the ELF regions of the
+ * kernel, sigma0 and the root task exist. To not collide with them, the load
+ * ranges from the program headers of these modules are reserved first. This
+ * requires uncompressed ELF files with the program headers in the first page,
+ * otherwise a collision is only detected when the binary is loaded.
+ */
+class Boot_modules_efi : public Boot_modules_list
+{
+public:
+  /**
+   * Read the module list.
+   *
+   * \retval true   Modules are provided on the boot volume.
+   * \retval false  No module list found.
+   */
+  bool probe();
+
+  void init_mod_regions() override;
+  l4util_l4mod_info *construct_mbi(unsigned long mod_addr,
+                                   Internal_module_list const &mods) override;
+
+private:
+  EFI_FILE_HANDLE open(char const *name);
+  void reserve_load_range(unsigned index);
+  void load(unsigned index, Region::Type type);
+
+  EFI_FILE_HANDLE _root = nullptr;
+  bool _probed = false;
+};
@@ -19,8 +19,7 @@
 #include "exec.h"
 
 int
-exec_load_elf(exec_handler_func_t *handler, void *opaque,
-              Boot_modules::Module const &m,const char **error_msg)
+Elf_segments::init(Boot_modules::Module const &m, const char **error_msg)
 {
   auto x = reinterpret_cast<ElfW(Ehdr) const *>(m.start);
   /* Read the ELF header.  */
@@ -32,19 +31,93 @@ exec_load_elf(exec_handler_func_t *handler, void *opaque,
   if (!l4util_elf_check_arch(x))
     return *error_msg="wrong ELF architecture", -1;
 
+  _num_phdrs = 0;
+  _cached = true;
+  _entry = x->e_entry;
+
   l4_addr_t phdr = reinterpret_cast<l4_addr_t>(l4util_elf_phdr(x));
 
   for (int i = 0; i < x->e_phnum; i++)
     {
       auto *ph = reinterpret_cast<ElfW(Phdr) const *>(phdr + i * x->e_phentsize);
-      if (ph->p_type == 0)
+      if (!relevant(ph))
         continue;
 
-      int res = (*handler)(opaque, ph, m);
+      if (_cached && _num_phdrs >= Max_phdrs)
+        {
+          // Too many headers to cache, for_each() walks the program header
+          // table of the module instead. Only the first KIP and kernel options
+          // headers are retained for find_hdr().
+          unsigned n = _num_phdrs;
+          _cached = false;
+          _num_phdrs = 0;
+          for (unsigned j = 0; j < n; j++)
+            if (l4_header(&_phdrs[j]) && !find_hdr(_phdrs[j].p_type))
+              _phdrs[_num_phdrs++] = _phdrs[j];
+        }
+
+      if (!_cached && (!l4_header(ph) || find_hdr(ph->p_type)))
+        continue;
 
-      if (res != 0)
-        return *error_msg="", res;
+      memcpy(&_phdrs[_num_phdrs++], ph, sizeof(*ph));
     }
 
   return *error_msg="", 0;
 }
+
+bool
+Elf_segments::relevant(ElfW(Phdr) const *ph)
+{
+  switch (ph->p_type)
+    {
+    case PT_LOAD:
+    case PT_DYNAMIC:
+      return true;
+    default:
+      return l4_header(ph);
+    }
+}
+
+bool
+Elf_segments::l4_header(ElfW(Phdr) const *ph)
+{
+  return ph->p_type == PT_CUSTOM_L4_KIP || ph->p_type == PT_CUSTOM_L4_KOPT;
+}
+
+int
+Elf_segments::for_each(exec_handler_func_t *handler, void *opaque,
+                       Boot_modules::Module const &m) const
+{
+  if (!_cached)
+    {
+      auto x = reinterpret_cast<ElfW(Ehdr) const *>(m.start);
+      l4_addr_t phdr = reinterpret_cast<l4_addr_t>(l4util_elf_phdr(x));
+      for (int i = 0; i < x->e_phnum; i++)
+        {
+          auto *ph = reinterpret_cast<ElfW(Phdr) const *>(phdr + i * x->e_phentsize);
+          if (!relevant(ph))
+            continue;
+
+          if (int res = (*handler)(opaque, ph, m))
+            return res;
+        }
+
+      return 0;
+    }
+
+  for (unsigned i = 0; i < _num_phdrs; i++)
+    if (int res = (*handler)(opaque, &_phdrs[i], m))
+      return res;
+
+  return 0;
+}
+
+ElfW(Phdr) const *
+Elf_segments::find_hdr(unsigned type) const
+{
+  for (unsigned i = 0; i < _num_phdrs; i++)
+    if (_phdrs[i].p_type == type)
+      return &_phdrs[i];
+
+  return nullptr;
+}
@@ -19,5 +19,60 @@ enum : unsigned { PT_CUSTOM_L4_KIP = 0x10, PT_CUSTOM_L4_KOPT = 0x11 };
 typedef int exec_handler_func_t(void *opaque, ElfW(Phdr) const *ph,
                                 Boot_modules::Module const &m);
 
-int exec_load_elf(exec_handler_func_t *handler_exec, void *opaque,
-                  Boot_modules::Module const &m, const char **error_msg);
+/**
+ * Program headers of an ELF boot module relevant to bootstrap.
+ *
+ * The ELF header and the program header table of a module are parsed only
+ * once. All later passes (region setup, KIP / kernel options lookup, loading)
+ * work on this compact copy and do not touch the module image again except for
+ * the actual segment contents. Should a module have more than Max_phdrs
+ * relevant program headers, for_each() walks the program header table of the
+ * module itself instead.
+ */
+class Elf_segments
+{
+public:
+  enum { Max_phdrs = 16 };
+
+  /**
+   * Parse the ELF header and the program headers of a module.
+   *
+   * Only headers of type PT_LOAD, PT_DYNAMIC, PT_CUSTOM_L4_KIP and
+   * PT_CUSTOM_L4_KOPT are retained.
+   *
+   * \retval 0   Success.
+   * \retval <0  Error, `error_msg` describes the problem.
+   */
+  int init(Boot_modules::Module const &m, const char **error_msg);
+
+  /**
+   * Invoke `handler` for each retained program header.
+   *
+   * \param m  The module the headers belong to. The module may have been moved
+   *           since init() was called.
+   *
+   * \return 0 if `handler` returned 0 for all headers, otherwise the first
+   *         non-zero return value of `handler`.
+   */
+  int for_each(exec_handler_func_t *handler, void *opaque,
+               Boot_modules::Module const &m) const;
+
+  /**
+   * Find the first program header of the given type, nullptr if none.
+   *
+   * Only for PT_CUSTOM_L4_KIP and PT_CUSTOM_L4_KOPT, which are always cached.
+   */
+  ElfW(Phdr) const *find_hdr(unsigned type) const;
+
+  /// Entry point of the binary as stated in the ELF header.
+  l4_addr_t entry() const { return _entry; }
+
+private:
+  static bool relevant(ElfW(Phdr) const *ph);
+  static bool l4_header(ElfW(Phdr) const *ph);
+
+  ElfW(Phdr) _phdrs[Max_phdrs];
+  unsigned _num_phdrs = 0;
+  bool _cached = true;
+  l4_addr_t _entry = 0;
+};
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2023-2025 Kernkonzept GmbH.
+ * Author(s): Georg Kotheimer <georg.kotheimer@kernkonzept.com>
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+/// Enforces ordering between MMIO register access and/or shared memory accesses.
+#if defined(__ARM_ARCH) && (__ARM_ARCH == 5 || __ARM_ARCH == 6)
+static inline void io_mb() { asm volatile("mcr p15, 0, %0, c7, c10, 4" : : "r" (0) : "memory"); }
+#elif defined(__ARM_ARCH) && __ARM_ARCH == 7
+static inline void io_mb() { asm volatile ("dsb" : : : "memory"); }
+#elif defined(__ARM_ARCH) && __ARM_ARCH >= 8
+// Since ARMv8 the memory model is other-multi-copy atomic, i.e. a memory write
+// observed by an observer is also visible to all other observers. In other
+// words, the memory write is either visible only locally to the originator (for
+// example, in its store buffer) or visible globally to all observers, i.e. it
+// is propagated to all observers at the same time.
+// Therefore, an dmb is sufficient to ensure that not only the CPU and device
+// agree on the order of MMIO register accesses and shared memory accesses, but
+// also a potential DMA master via which the device performs DMA operations.
+static inline void io_mb() { asm volatile ("dmb osh" : : : "memory"); }
+#elif defined(__mips__)
+static inline void io_mb() { asm volatile ("sync" : : : "memory"); }
+#elif defined(__amd64__) || defined(__i386__) || defined(__i686__)
+static inline void io_mb() { asm volatile ("mfence" : : : "memory"); }
+#elif defined(__riscv)
+static inline void io_mb() { asm volatile ("fence iorw, iorw" : : : "memory"); }
+#else
+#error Missing proper memory write barrier
+#endif
@@ -26,6 +26,7 @@
 #include <l4/cxx/basic_ostream>
 #include <l4/sys/compiler.h>
 
+#include "boot_log.h"
 #include "support.h"
 #include "platform.h"
 
@@ -33,12 +34,40 @@ Platform_base *Platform_base::platform;
 
 static L4::Uart *stdio_uart;
 
+unsigned log_level = Log_verbose;
+
 L4::Uart *uart()
 { return stdio_uart; }
 
 void set_stdio_uart(L4::Uart *uart)
 { stdio_uart = uart; }
 
+void console_write(char const *s, unsigned long len)
+{
+  if (!uart())
+    return;
+
+  // Hand the output to the UART driver in chunks instead of single characters
+  // so that it can fill the transmit FIFO per status check.
+  char buf[64];
+  unsigned n = 0;
+  while (len--)
+    {
+      char c = *s++;
+      if (n >= sizeof(buf) - 1)
+        {
+          uart()->write(buf, n);
+          n = 0;
+        }
+      if (c == '\n')
+        buf[n++] = '\r';
+      buf[n++] = c;
+    }
+
+  if (n)
+    uart()->write(buf, n);
+}
+
 
 inline void *operator new (size_t, void *p) { return p; }
 // IO Stream backend
@@ -126,6 +155,7 @@ __assert_fail(const char *assertion, const char *filename, int linenumber,
 noexcept(noexcept(__assert_fail(assertion, filename, linenumber, function)))
 #endif
 {
+  Boot_log::error();
   printf("%s:%d: %s: Assertion `%s' failed.\n",
 				filename,
 				linenumber,
@@ -140,24 +170,18 @@ noexcept(noexcept(__assert_fail(assertion, filename, linenumber, function)))
 ssize_t
 write(int fd, const void *buf, size_t count)
 {
-  if (!uart())
-    return count;
-
   if (fd == STDOUT_FILENO || fd == STDERR_FILENO)
     {
       char const *b = reinterpret_cast<char const *>(buf);
-      int i = count;
-      while (i--)
-        {
-          char c = *b++;
-          if (c == '\n')
-            uart()->write("\r", 1);
-          uart()->write(&c, 1);
-        }
+      if (!Boot_log::write(b, count))
+        console_write(b, count);
 
       return count;
     }
 
+  if (!uart())
+    return count;
+
   errno = EBADF;
   return -1;
 }
@@ -167,6 +191,7 @@ int
 getchar(void)
 {
   int c;
+  Boot_log::flush();
   if (!uart())
     return -1;
 
@@ -204,6 +229,7 @@ void
 panic(const char *fmt, ...)
 {
   va_list v;
+  Boot_log::error();
   putchar('\n');
   va_start (v, fmt);
   vprintf(fmt, v);
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+/**
+ * Leveled diagnostic output.
+ *
+ * Messages above BOOTSTRAP_LOG_LEVEL are removed at compile time including
+ * their format strings and arguments. Of the remaining messages, only those
+ * up to the runtime level set with `-loglevel=<n>` are printed.
+ *
+ * Errors bypass the boot log buffer (see Boot_log) and go to the UART right
+ * away, also with `-quiet`.
+ */
+enum Log_level : unsigned
+{
+  Log_error   = 0,  ///< Errors, usually followed by a panic
+  Log_warn    = 1,  ///< Warnings, the system might not work as expected
+  Log_info    = 2,  ///< Main steps of the boot process
+  Log_verbose = 3,  ///< Details like region lists and module moves
+  Log_debug   = 4,  ///< Hex dumps and other developer information
+};
+
+#ifndef BOOTSTRAP_LOG_LEVEL
+#define BOOTSTRAP_LOG_LEVEL 3
+#endif
+
+/// Runtime log level, Log_verbose unless changed with `-loglevel=`.
+extern unsigned log_level;
+
+static inline bool __attribute__((always_inline))
+log_enabled(unsigned level)
+{ return level <= BOOTSTRAP_LOG_LEVEL && level <= log_level; }
+
+#define log_printf(level, ...) \
+  do { if (log_enabled(level)) printf(__VA_ARGS__); } while (0)
+
+/// Write the buffered console output and stop buffering, see Boot_log::error().
+void log_unbuffer();
+
+#define log_error(...) \
+  do { if (log_enabled(Log_error)) { log_unbuffer(); printf(__VA_ARGS__); } } \
+  while (0)
+
+#define log_warn(...)    log_printf(Log_warn, __VA_ARGS__)
+#define log_info(...)    log_printf(Log_info, __VA_ARGS__)
+#define log_verbose(...) log_printf(Log_verbose, __VA_ARGS__)
+#define log_debug(...)   log_printf(Log_debug, __VA_ARGS__)
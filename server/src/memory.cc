@@ -1,5 +1,6 @@
 #include "memory.h"
 #include "region.h"
+#include "startup.h"
 
 #include <l4/cxx/minmax>
 
@@ -10,6 +11,10 @@ Memory::find_free_ram(unsigned long size,
                       unsigned align,
                       unsigned node)
 {
+  // Memory beyond mem_end is not accessible (yet)
+  if (max_addr > mem_end)
+    max_addr = mem_end;
+
   unsigned long min = min_addr;
   if (min < sizeof(unsigned long long))
     min = sizeof(unsigned long long);
@@ -49,7 +54,10 @@ Memory::find_free_ram_rev(unsigned long size,
   if (min_addr < sizeof(unsigned long long))
     min_addr = sizeof(unsigned long long);
 
+  // Memory beyond mem_end is not accessible (yet)
   unsigned long max = max_addr;
+  if (max > mem_end)
+    max = mem_end;
   for (Region *rr = ram->end() - 1; rr >= ram->begin(); --rr)
     {
       if (min_addr >= rr->end())
@@ -115,6 +115,9 @@ class Mod_attr_list
     Descriptor next() const
     { return valid() ? Descriptor(_d + size()) : Descriptor(); }
 
+    /// Address behind the descriptor
+    char const *end() const { return _d + size(); }
+
     cxx::String key() const
     { return cxx::String(_d + header_size(), key_size()); }
 
@@ -163,6 +166,19 @@ public:
 
   static Mod_attr_list global() { return Mod_attr_list(_global_attrs); }
 
+  /// Address behind the terminator of the list, nullptr if there is no list.
+  char const *data_end() const
+  {
+    if (!_head)
+      return nullptr;
+
+    char const *p = _head;
+    for (Descriptor d(p); d; d = Descriptor(p))
+      p = d.end();
+
+    return p + 1;
+  }
+
   cxx::String find(cxx::String const &key) const
   {
     for (auto const &i : *this)
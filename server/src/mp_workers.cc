@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <l4/sys/consts.h>
+
+#include "bulk_copy.h"
+#include "log.h"
+#include "mp_workers.h"
+#include "platform.h"
+#include "timestamp.h"
+
+extern "C" {
+char mp_worker_stacks[Mp_workers::Max_workers][Mp_workers::Stack_size]
+  __attribute__((aligned(16)));
+extern l4_umword_t const mp_worker_stack_size = Mp_workers::Stack_size;
+extern l4_umword_t const mp_worker_max_slots = Mp_workers::Max_workers;
+}
+
+namespace {
+
+enum
+{
+  // Keep per-CPU data apart, writers might not share cache state
+  Line_size = 128,
+  // Give CPUs this long to show up before going on without them
+  Checkin_timeout_us = 100000,
+  Checkin_timeout_loops = 50000000,
+};
+
+/**
+ * Shared state of one worker slot, only written by the worker.
+ */
+struct alignas(Line_size) Worker_state
+{
+  unsigned volatile checkin;   ///< Epoch the worker entered
+  unsigned volatile job_done;  ///< Last job sequence completed
+  unsigned volatile exited;    ///< Epoch the worker left
+  l4_uint64_t bytes;           ///< Bytes processed
+  l4_uint64_t ticks;           ///< Time spent processing
+};
+
+/**
+ * Assignment of one worker slot, only written by the boot CPU.
+ */
+struct alignas(Line_size) Worker_ctl
+{
+  unsigned volatile accepted;  ///< Epoch the worker was accepted for
+  unsigned part;               ///< Part of each job to process
+};
+
+enum Op { Op_fill, Op_copy, Op_call };
+
+struct alignas(Line_size) Job
+{
+  Op op;
+  l4_addr_t dst;
+  l4_addr_t src;
+  l4_size_t size;     ///< Bytes, or number of items for Op_call
+  l4_uint8_t val;
+  Mp_workers::Item_fn fn;
+  void *arg;
+  unsigned nparts;
+};
+
+Worker_state workers[Mp_workers::Max_workers];
+Worker_ctl ctl[Mp_workers::Max_workers];
+Job job;
+
+/// Odd while workers are running, even while they shall park
+unsigned volatile epoch;
+/// Epoch for which the boot CPU has decided which workers to use
+unsigned volatile decided;
+/// Sequence number of the last submitted job
+unsigned volatile job_seq;
+
+/// Workers accepted for the current epoch
+unsigned active_mask;
+unsigned num_active;
+/// Workers that did not show up before, not waited for again
+unsigned absent_mask;
+
+l4_uint64_t boot_bytes;
+l4_uint64_t boot_ticks;
+
+inline void mb()
+{
+#if defined(ARCH_arm64) || defined(ARCH_arm)
+  // Also orders accesses to Device memory, i.e. with MMU disabled
+  asm volatile ("dmb sy" : : : "memory");
+#else
+  __sync_synchronize();
+#endif
+}
+
+inline void relax()
+{
+#if defined(ARCH_x86) || defined(ARCH_amd64)
+  asm volatile ("pause" : : : "memory");
+#else
+  asm volatile ("" : : : "memory");
+#endif
+}
+
+/**
+ * Process one part of the current job.
+ *
+ * Parts of memory jobs are page-aligned to keep CPUs from writing into the
+ * same cache line.
+ */
+void run_part(unsigned part, l4_uint64_t *bytes, l4_uint64_t *ticks)
+{
+  if (job.op == Op_call)
+    {
+      l4_uint64_t t = timestamp();
+      for (l4_size_t i = part; i < job.size; i += job.nparts)
+        *bytes += job.fn(i, job.arg);
+      *ticks += timestamp() - t;
+      return;
+    }
+
+  l4_size_t chunk = l4_round_page((job.size + job.nparts - 1) / job.nparts);
+  l4_size_t offs = chunk * part;
+  if (offs >= job.size)
+    return;
+
+  l4_size_t size = job.size - offs;
+  if (size > chunk)
+    size = chunk;
+
+  l4_uint64_t t = timestamp();
+  void *dst = reinterpret_cast<void *>(job.dst + offs);
+  if (job.op == Op_copy)
+    bulk_move(dst, reinterpret_cast<void const *>(job.src + offs), size);
+  else if (job.val)
+    memset(dst, job.val, size);
+  else
+    bulk_zero(dst, size);
+
+  *ticks += timestamp() - t;
+  *bytes += size;
+}
+
+/**
+ * Let all active workers process the job, process part 0 on the boot CPU and
+ * wait for the workers to finish.
+ */
+void run_job()
+{
+  job.nparts = num_active + 1;
+
+  if (num_active)
+    {
+      mb();
+      job_seq = job_seq + 1;
+      mb();
+    }
+
+  run_part(0, &boot_bytes, &boot_ticks);
+
+  for (unsigned i = 0; i < Mp_workers::Max_workers; ++i)
+    if (active_mask & (1U << i))
+      while (workers[i].job_done != job_seq)
+        relax();
+
+  mb();
+}
+
+}
+
+void
+mp_worker_main(unsigned slot)
+{
+  unsigned e = epoch;
+  if (!(e & 1) || slot >= Mp_workers::Max_workers)
+    return;
+
+  Worker_state *w = &workers[slot];
+  w->checkin = e;
+  mb();
+
+  while (decided != e)
+    {
+      if (epoch != e)
+        return;
+      relax();
+    }
+
+  if (ctl[slot].accepted != e)
+    return;
+
+  unsigned seq = job_seq;
+  for (;;)
+    {
+      while (job_seq == seq && epoch == e)
+        relax();
+
+      if (epoch != e)
+        break;
+
+      mb();
+      seq = job_seq;
+      run_part(ctl[slot].part, &w->bytes, &w->ticks);
+      mb();
+      w->job_done = seq;
+    }
+
+  mb();
+  w->exited = e;
+}
+
+unsigned
+Mp_workers::start()
+{
+  memset(workers, 0, sizeof(workers));
+  boot_bytes = boot_ticks = 0;
+  active_mask = num_active = 0;
+
+  epoch = epoch + 1;
+  mb();
+
+  unsigned expected = Platform_base::platform->start_workers(Max_workers)
+                      & ~absent_mask;
+  if (!expected)
+    return 0;
+
+  // Wait for all expected workers, but do not rely on all of them to show up.
+  l4_uint64_t freq = timestamp_freq();
+  l4_uint64_t t = timestamp();
+  for (unsigned long loops = 0;; ++loops)
+    {
+      unsigned arrived = 0;
+      for (unsigned i = 0; i < Max_workers; ++i)
+        if (workers[i].checkin == epoch)
+          arrived |= 1U << i;
+
+      if ((arrived & expected) == expected)
+        break;
+
+      if (freq ? timestamp_to_us(timestamp() - t) > Checkin_timeout_us
+               : loops > Checkin_timeout_loops)
+        {
+          printf("  MP workers: CPUs %x did not show up.\n",
+                 expected & ~arrived);
+          absent_mask |= expected & ~arrived;
+          break;
+        }
+      relax();
+    }
+
+  for (unsigned i = 0; i < Max_workers; ++i)
+    if (workers[i].checkin == epoch)
+      {
+        ctl[i].accepted = epoch;
+        ctl[i].part = ++num_active;
+        active_mask |= 1U << i;
+      }
+
+  mb();
+  decided = epoch;
+  return num_active;
+}
+
+void
+Mp_workers::stop()
+{
+  mb();
+  unsigned e = epoch;
+  epoch = e + 1;
+  mb();
+
+  for (unsigned i = 0; i < Max_workers; ++i)
+    if (active_mask & (1U << i))
+      while (workers[i].exited != e)
+        relax();
+
+  Platform_base::platform->stop_workers();
+  active_mask = num_active = 0;
+}
+
+void
+Mp_workers::fill(l4_addr_t dst, l4_size_t size, l4_uint8_t val)
+{
+  job.op = Op_fill;
+  job.dst = dst;
+  job.size = size;
+  job.val = val;
+  run_job();
+}
+
+void
+Mp_workers::copy(l4_addr_t dst, l4_addr_t src, l4_size_t size)
+{
+  job.op = Op_copy;
+  job.dst = dst;
+  job.src = src;
+  job.size = size;
+  run_job();
+}
+
+void
+Mp_workers::run(unsigned num, Item_fn fn, void *arg)
+{
+  job.op = Op_call;
+  job.size = num;
+  job.fn = fn;
+  job.arg = arg;
+  run_job();
+}
+
+static void
+print_throughput(l4_uint64_t bytes, l4_uint64_t ticks)
+{
+  l4_uint64_t us = timestamp_to_us(ticks);
+  printf("%llu MiB", bytes >> 20);
+  if (us)
+    printf(" in %llu ms, %llu MiB/s\n", us / 1000, (bytes * 1000000 / us) >> 20);
+  else
+    printf(" in %llu ticks\n", ticks);
+}
+
+void
+Mp_workers::report(char const *what)
+{
+  if (!log_enabled(Log_verbose))
+    return;
+
+  printf("  %s on %u CPU%s:\n", what, num_active + 1, num_active ? "s" : "");
+  printf("    boot CPU: ");
+  print_throughput(boot_bytes, boot_ticks);
+  for (unsigned i = 0; i < Max_workers; ++i)
+    if (active_mask & (1U << i))
+      {
+        printf("    worker %u: ", i);
+        print_throughput(workers[i].bytes, workers[i].ticks);
+      }
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include <l4/sys/l4int.h>
+
+/**
+ * Secondary CPUs doing work for the boot CPU.
+ *
+ * The platform brings up the secondary CPUs (see Platform_base::start_workers())
+ * which then enter mp_worker_main() with their worker slot. Jobs are submitted
+ * by the boot CPU and processed by all participating CPUs including the boot
+ * CPU, each job call returns when all parts are done. Parts are assigned
+ * statically, so no atomic operations are needed: those may not work while the
+ * MMU is disabled.
+ *
+ * Without workers, e.g. before start() or if the platform has no means to
+ * start secondary CPUs, the boot CPU processes the jobs on its own.
+ *
+ * stop() returns the CPUs to the state they were in before start(), i.e. to
+ * the state the kernel expects.
+ */
+class Mp_workers
+{
+public:
+  enum
+  {
+    Max_workers = 16,
+    Stack_size  = 4096,
+  };
+
+  /**
+   * Bring up the secondary CPUs of the platform.
+   *
+   * Workers are only used if the boot CPU and the workers see the same memory
+   * contents, i.e. they run with the same cache state.
+   *
+   * \return Number of workers that are available.
+   */
+  static unsigned start();
+
+  /**
+   * Return the workers to their parked state.
+   */
+  static void stop();
+
+  /**
+   * Process one item of a job submitted with run().
+   *
+   * Runs on any CPU, so it must neither print, allocate memory nor touch
+   * state shared with other items.
+   *
+   * \return Number of bytes processed, for report().
+   */
+  typedef l4_size_t (*Item_fn)(unsigned item, void *arg);
+
+  /**
+   * Fill memory, split between the boot CPU and all workers.
+   *
+   * \param dst   Start of the memory area.
+   * \param size  Size of the memory area.
+   * \param val   Fill value.
+   */
+  static void fill(l4_addr_t dst, l4_size_t size, l4_uint8_t val);
+
+  /**
+   * Copy memory, split between the boot CPU and all workers.
+   *
+   * \param dst   Destination, must not overlap with the source.
+   * \param src   Source.
+   * \param size  Number of bytes to copy.
+   */
+  static void copy(l4_addr_t dst, l4_addr_t src, l4_size_t size);
+
+  /**
+   * Call `fn` for the items 0 to `num` - 1, distributed round-robin between
+   * the boot CPU and all workers.
+   */
+  static void run(unsigned num, Item_fn fn, void *arg);
+
+  /**
+   * Print the amount of work done and the throughput per CPU.
+   *
+   * Must be called before stop().
+   *
+   * \param what  Description of the work.
+   */
+  static void report(char const *what);
+};
+
+/**
+ * Entry for workers, called with a stack set up by the platform.
+ *
+ * \param slot  Worker slot as announced by the platform, < Max_workers.
+ *
+ * Returns when the worker is not needed any longer.
+ */
+extern "C" void mp_worker_main(unsigned slot);
@@ -53,6 +53,26 @@ public:
   virtual void init_dt() {}
   virtual void add_dt_module(Internal_module_list &) {}
 
+  /**
+   * Replace the device tree with a compacted copy, see `-dtcompact`. Invoked
+   * after the memory map is set up but before the modules are placed.
+   */
+  virtual void compact_dt() {}
+
+  /**
+   * Add a module with a summary of the platform information, e.g. parsed
+   * from the device tree. Invoked after the memory map is set up but before
+   * the modules are placed.
+   */
+  virtual void add_platform_summary(Internal_module_list &) {}
+
+  /**
+   * Make the RAM not yet accessible to bootstrap available for placing the
+   * modules. Invoked after the ELF regions are reserved, so memory needed
+   * for page tables does not collide with them.
+   */
+  virtual void map_upper_ram() {}
+
   /**
    * Invoked late during startup, when the memory map is already set up and all
    * modules are loaded or moved. This allows allocating memory without the risk
@@ -80,6 +100,23 @@ public:
   virtual void finalize_regions()
   { modules()->finalize_mod_regions(); }
 
+  /**
+   * Let secondary CPUs enter mp_worker_main() on their stack from
+   * mp_worker_stacks, see Mp_workers.
+   *
+   * \param max_slots  Number of available worker slots.
+   *
+   * \return Bit mask of the worker slots that are expected to show up.
+   */
+  virtual unsigned start_workers(unsigned /* max_slots */)
+  { return 0; }
+
+  /**
+   * Called after all workers left mp_worker_main() to wait until they reached
+   * their parked state again.
+   */
+  virtual void stop_workers() {}
+
   virtual void boot_kernel(unsigned long entry)
   {
     typedef void (*func)(void);
@@ -6,12 +6,15 @@
  */
 
 #include <l4/drivers/uart_pl011.h>
+#include "bulk_copy.h"
 #include "support.h"
 #include "startup.h"
 #include "panic.h"
 #include "platform_dt-arm.h"
 #include "qemu_fw_cfg.h"
+#include "qemu_fw_cfg_modules.h"
 #include "qemu_ramfb.h"
+#include "virtio_blk_modules.h"
 
 extern char _start;
 
@@ -42,7 +45,7 @@ class Platform_arm_virt : public Platform_dt_arm
 
     unsigned sz = fdt_totalsize(fdt);
     l4_addr_t dst = l4_trunc_page(reinterpret_cast<unsigned long>(&_start) - sz);
-    memmove((void *)dst, fdt, sz);
+    bulk_move((void *)dst, fdt, sz);
     return dst;
   }
 
@@ -59,12 +62,26 @@ class Platform_arm_virt : public Platform_dt_arm
 
   void setup_fw_cfg()
   {
+    if (Fw_cfg::is_present())
+      return;
+
     Dt::Node fw_cfg = dt.node_by_compatible("qemu,fw-cfg-mmio");
     l4_uint64_t fw_cfg_addr;
     if (fw_cfg.is_valid() && fw_cfg.get_reg(0, &fw_cfg_addr))
       Fw_cfg::init_mmio(fw_cfg_addr);
   }
 
+  Boot_modules *modules() override
+  {
+    setup_fw_cfg();
+    if (fw_cfg_mods.probe())
+      return &fw_cfg_mods;
+
+    // Replaces the modules linked into the image if present
+    virtio_blk_mods.load(dt);
+    return this;
+  }
+
   l4util_l4mod_info *construct_mbi(unsigned long mod_addr,
                                    Internal_module_list const &mods) override
   {
@@ -89,6 +106,9 @@ class Platform_arm_virt : public Platform_dt_arm
   {
     reboot_psci();
   }
+
+  Boot_modules_fw_cfg fw_cfg_mods;
+  Virtio_blk_modules virtio_blk_mods;
 };
 }
 
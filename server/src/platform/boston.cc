@@ -10,7 +10,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-#include <l4/drivers/uart_16550.h>
+#include "uart_16550_fifo.h"
 #include "support.h"
 #include "panic.h"
 #include "platform-mips.h"
@@ -31,7 +31,7 @@ public:
     kuart.base_address = 0x17ffe000;
     kuart.irqno        = 3;
 
-    static L4::Uart_16550 _uart(kuart.base_baud, 0, 0, 8, 0);
+    static Uart_16550_fifo _uart(kuart.base_baud, 0, 0, 8, 0);
     static L4::Io_register_block_mmio_fixed_width<unsigned>
                  r(kuart.base_address + Mips::KSEG1, kuart.reg_shift);
 
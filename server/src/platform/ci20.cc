@@ -7,7 +7,7 @@
 #include <stdio.h>
 
 #ifdef CONFIG_DRIVERS_FRST_UART_DRV_8250
-#include <l4/drivers/uart_16550.h>
+#include "uart_16550_fifo.h"
 #endif
 #include <l4/sys/compiler.h>
 #include "memory.h"
@@ -52,7 +52,7 @@ public:
         break;
       }
 
-    static L4::Uart_16550 _uart(kuart.base_baud, 0, 0, 0, 0x10 /* FCR UME */);
+    static Uart_16550_fifo _uart(kuart.base_baud, 0, 0, 0, 0x10 /* FCR UME */);
     static L4::Io_register_block_mmio r(kuart.base_address + Mips::KSEG1,
                                         kuart.reg_shift);
 
@@ -6,7 +6,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-#include <l4/drivers/uart_16550.h>
+#include "uart_16550_fifo.h"
 #include <l4/sys/compiler.h>
 #include "support.h"
 #include "platform-mips.h"
@@ -25,7 +25,7 @@ public:
     kuart.base_address = 0x18101500; // UART1
     kuart.irqno        = 25; // GIC-25
 
-    static L4::Uart_16550 _uart(kuart.base_baud, 0, 0, 0, 0x10 /* FCR UME */);
+    static Uart_16550_fifo _uart(kuart.base_baud, 0, 0, 0, 0x10 /* FCR UME */);
     static L4::Io_register_block_mmio r(kuart.base_address + Mips::KSEG1,
                                         kuart.reg_shift);
 
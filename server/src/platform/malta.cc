@@ -11,7 +11,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-#include <l4/drivers/uart_16550.h>
+#include "uart_16550_fifo.h"
 #include "memory.h"
 #include "support.h"
 #include "panic.h"
@@ -69,7 +69,7 @@ public:
     kuart.irqno        = I8259A_IRQ_UART_TTY0;
     kuart.baud         = 115200;
 
-    static L4::Uart_16550 _uart(kuart.base_baud, 0, 0, 8 /*out2 */, 0);
+    static Uart_16550_fifo _uart(kuart.base_baud, 0, 0, 8 /*out2 */, 0);
     static L4::Io_register_block_mmio r(kuart.base_address + Mips::KSEG1,
                                         kuart.reg_shift);
 
@@ -1,6 +1,6 @@
 #include <startup.h>
 #include "support.h"
-#include <l4/drivers/uart_16550.h>
+#include "uart_16550_fifo.h"
 
 static void setup_16550_mmio_uart(L4::Uart_16550 *uart)
 {
@@ -7,6 +7,7 @@
 
 #include <l4/drivers/uart_tegra-tcu.h>
 #include "acpi.h"
+#include "bulk_copy.h"
 #include "dt.h"
 #include "efi-support.h"
 #include "panic.h"
@@ -78,7 +79,7 @@ public:
     if (!_fdt)
       panic("Could not allocate memory for DT");
 
-    memcpy(_fdt, efi.fdt(), fdt_size);
+    bulk_move(_fdt, efi.fdt(), fdt_size);
     mem_manager->regions->add(Region::start_size(_fdt, fdt_size));
 
     Dt_module dt_module(reinterpret_cast<unsigned long>(_fdt), fdt_size);
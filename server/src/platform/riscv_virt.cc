@@ -7,7 +7,9 @@
 
 #include "platform_riscv.h"
 #include "qemu_fw_cfg.h"
+#include "qemu_fw_cfg_modules.h"
 #include "qemu_ramfb.h"
+#include "virtio_blk_modules.h"
 #include "startup.h"
 
 namespace {
@@ -20,12 +22,26 @@ class Platform_riscv_virt : public Platform_riscv_base
 
   void setup_fw_cfg()
   {
+    if (Fw_cfg::is_present())
+      return;
+
     Dt::Node fw_cfg = dt.node_by_compatible("qemu,fw-cfg-mmio");
     l4_uint64_t fw_cfg_addr;
     if (fw_cfg.is_valid() && fw_cfg.get_reg(0, &fw_cfg_addr))
       Fw_cfg::init_mmio(fw_cfg_addr);
   }
 
+  Boot_modules *modules() override
+  {
+    setup_fw_cfg();
+    if (fw_cfg_mods.probe())
+      return &fw_cfg_mods;
+
+    // Replaces the modules linked into the image if present
+    virtio_blk_mods.load(dt);
+    return this;
+  }
+
   l4util_l4mod_info *construct_mbi(unsigned long mod_addr,
                                    Internal_module_list const &mods) override
   {
@@ -41,6 +57,9 @@ class Platform_riscv_virt : public Platform_riscv_base
 
     l4_infinite_loop();
   }
+
+  Boot_modules_fw_cfg fw_cfg_mods;
+  Virtio_blk_modules virtio_blk_mods;
 };
 }
 
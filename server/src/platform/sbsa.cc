@@ -7,7 +7,7 @@
  */
 
 #include <l4/drivers/uart_pl011.h>
-#include <l4/drivers/uart_16550.h>
+#include "uart_16550_fifo.h"
 
 #include "acpi.h"
 #include "efi-support.h"
@@ -24,6 +24,7 @@ char const * const psci_methods[] = { "unsupported", "SMC", "HVC" };
 class Platform_arm_sbsa : public Platform_dt_arm
 {
   unsigned _uart_variant;
+  Boot_modules_efi _efi_mods;
 
   void set_compatible_from_uart_variant(unsigned variant)
   {
@@ -129,7 +130,13 @@ public:
     efi.setup_gop();
   }
 
-  Boot_modules *modules() override { return this; }
+  Boot_modules *modules() override
+  {
+    // Prefer modules on the boot volume over the ones linked into the image
+    if (_efi_mods.probe())
+      return &_efi_mods;
+    return this;
+  }
 
   void setup_memory_map() override
   {
@@ -174,7 +181,7 @@ public:
 
     // EFI console is gone. Use our own UART driver from now on...
     static L4::Io_register_block_mmio r(kuart.base_address);
-    static L4::Uart_16550 _uart_16550(kuart.base_baud);
+    static Uart_16550_fifo _uart_16550(kuart.base_baud);
     static L4::Uart_pl011 _uart_pl011(kuart.base_baud);
 
     L4::Uart *u = &_uart_pl011;
@@ -14,7 +14,7 @@
 #include <stdio.h>
 
 #ifdef CONFIG_DRIVERS_FRST_UART_DRV_8250
-#include <l4/drivers/uart_16550.h>
+#include "uart_16550_fifo.h"
 #endif
 
 #include "support.h"
@@ -49,7 +49,7 @@ public:
     kuart.baud = 115200;
 
 #ifdef CONFIG_DRIVERS_FRST_UART_DRV_8250
-    static L4::Uart_16550 _uart(kuart.base_baud, 0, 0, 8, 0);
+    static Uart_16550_fifo _uart(kuart.base_baud, 0, 0, 8, 0);
     static L4::Io_register_block_mmio r(kuart.base_address + Mips::KSEG1,
                                         kuart.reg_shift);
 
@@ -29,7 +29,7 @@ class Platform_arm_sunxi : public Platform_single_region_ram<Platform_arm>
     kuart_flags       |=   L4_kernel_options::F_uart_base
                          | L4_kernel_options::F_uart_baud
                          | L4_kernel_options::F_uart_irq;
-    static L4::Uart_16550 _uart(kuart.base_baud, 0, 0, 0, 0);
+    static Uart_16550_fifo _uart(kuart.base_baud, 0, 0, 0, 0);
     setup_16550_mmio_uart(&_uart);
   }
 };
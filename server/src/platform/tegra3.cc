@@ -41,7 +41,7 @@ class Platform_arm_tegra3 : public Platform_single_region_ram<Platform_arm>
                          | L4_kernel_options::F_uart_baud
                          | L4_kernel_options::F_uart_irq;
 
-    static L4::Uart_16550 _uart(kuart.base_baud, 0, 0, 0, 0);
+    static Uart_16550_fifo _uart(kuart.base_baud, 0, 0, 0, 0);
     setup_16550_mmio_uart(&_uart);
   }
 };
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include <l4/drivers/uart_16550.h>
+
+/**
+ * 16550 UART transmitting in bursts.
+ *
+ * The generic driver waits for an empty transmitter before every character.
+ * 16550A-class parts have a transmit FIFO which accepts Fifo_size characters
+ * once the transmitter is empty, so only one status check per burst is needed.
+ */
+class Uart_16550_fifo : public L4::Uart_16550
+{
+public:
+  using L4::Uart_16550::Uart_16550;
+
+  bool startup(L4::Io_register_block const *regs) override
+  {
+    if (!L4::Uart_16550::startup(regs))
+      return false;
+
+    _tx_regs = regs;
+    // IIR bits 7:6 read as 11 if the FIFOs are enabled
+    _tx_burst = (regs->read<unsigned char>(Iir) & 0xc0) == 0xc0 ? Fifo_size : 1;
+    return true;
+  }
+
+  int write(char const *s, unsigned long count,
+            bool blocking = true) const override
+  {
+    if (!_tx_regs)
+      return L4::Uart_16550::write(s, count, blocking);
+
+    unsigned long i = 0;
+    while (i < count)
+      {
+        while (!(_tx_regs->read<unsigned char>(Lsr) & Lsr_thre))
+          if (!blocking)
+            return i;
+
+        for (unsigned n = 0; n < _tx_burst && i < count; ++n)
+          _tx_regs->write<unsigned char>(Thr, s[i++]);
+      }
+
+    return count;
+  }
+
+private:
+  enum
+  {
+    Thr       = 0,
+    Iir       = 2,
+    Lsr       = 5,
+    Lsr_thre  = 0x20,
+    Fifo_size = 16,
+  };
+
+  L4::Io_register_block const *_tx_regs = nullptr;
+  unsigned _tx_burst = 1;
+};
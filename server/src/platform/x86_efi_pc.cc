@@ -57,7 +57,13 @@ public:
     Max_cmdline_length = 1024,
   };
 
-  Boot_modules *modules() override { return this; }
+  Boot_modules *modules() override
+  {
+    // Prefer modules on the boot volume over the ones linked into the image
+    if (_efi_mods.probe())
+      return &_efi_mods;
+    return this;
+  }
 
   void setup_memory_map() override
   {
@@ -83,6 +89,7 @@ public:
   }
 
   Uart_efi _efi_uart;
+  Boot_modules_efi _efi_mods;
 };
 
 Platform_x86_efi _x86_pc_platform;
@@ -162,6 +169,7 @@ EFI_STATUS efi_main(EFI_HANDLE image, EFI_SYSTEM_TABLE *systab)
               Platform_x86_efi::Max_cmdline_length - strlen(efi_cmdline));
     }
 
+  _x86_pc_platform.init_pci(efi.acpi_rsdp());
   _x86_pc_platform.setup_uart(efi_cmdline, &_x86_pc_platform._efi_uart);
   _x86_pc_platform.disable_pci_bus_master();
 
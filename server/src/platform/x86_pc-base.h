@@ -1,7 +1,8 @@
+#include "acpi.h"
 #include "support.h"
 #include "startup.h"
 
-#include <l4/drivers/uart_16550.h>
+#include "uart_16550_fifo.h"
 #include <l4/drivers/io_regblock_port.h>
 
 #include <string.h>
@@ -140,14 +141,41 @@ static int raw_keyboard_getscancode(void)
 }
 
 
+/// Memory-mapped configuration space (ECAM) of PCI segment 0, if any
+static struct
+{
+  l4_addr_t base;   ///< Address of bus 0
+  unsigned start_bus;
+  unsigned end_bus;
+} pci_ecam;
+
 static inline l4_uint32_t
 pci_conf_addr(l4_uint32_t bus, l4_uint32_t dev, l4_uint32_t fn, l4_uint32_t reg)
 { return 0x80000000 | (bus << 16) | (dev << 11) | (fn << 8) | (reg & ~3); }
 
+static inline volatile void *
+pci_ecam_addr(unsigned char bus, l4_uint32_t dev, l4_uint32_t fn,
+              l4_uint32_t reg)
+{
+  if (!pci_ecam.base || bus < pci_ecam.start_bus || bus > pci_ecam.end_bus)
+    return nullptr;
+
+  return reinterpret_cast<volatile void *>(
+    pci_ecam.base + ((bus << 20) | (dev << 15) | (fn << 12) | reg));
+}
+
 static l4_uint32_t pci_read(unsigned char bus, l4_uint32_t dev,
                             l4_uint32_t fn, l4_uint32_t reg,
                             unsigned char width)
 {
+  if (volatile void *a = pci_ecam_addr(bus, dev, fn, reg & ~(width / 8U - 1)))
+    switch (width)
+      {
+      case 8:  return *static_cast<volatile l4_uint8_t *>(a);
+      case 16: return *static_cast<volatile l4_uint16_t *>(a);
+      case 32: return *static_cast<volatile l4_uint32_t *>(a);
+      }
+
   l4util_out32(pci_conf_addr(bus, dev, fn, reg), 0xcf8);
 
   switch (width)
@@ -163,6 +191,17 @@ static void pci_write(unsigned char bus, l4_uint32_t dev,
                       l4_uint32_t fn, l4_uint32_t reg,
                       l4_uint32_t val, unsigned char width)
 {
+  if (volatile void *a = pci_ecam_addr(bus, dev, fn, reg & ~(width / 8U - 1)))
+    {
+      switch (width)
+        {
+        case 8:  *static_cast<volatile l4_uint8_t *>(a) = val; break;
+        case 16: *static_cast<volatile l4_uint16_t *>(a) = val; break;
+        case 32: *static_cast<volatile l4_uint32_t *>(a) = val; break;
+        }
+      return;
+    }
+
   l4util_out32(pci_conf_addr(bus, dev, fn, reg), 0xcf8);
 
   switch (width)
@@ -361,6 +400,200 @@ struct Pci_iterator
 
 };
 
+/**
+ * Table of the PCI functions of segment 0.
+ *
+ * Built by a single scan which starts at the root buses and follows the bus
+ * ranges of the PCI-to-PCI bridges instead of probing all buses. The root
+ * buses found in ACPI are scanned first, see set_root_buses(). As `_BBN` is
+ * optional and the bus ranges might be patched by AML at runtime, the buses
+ * not reached this way are still probed for further host bridges. If the
+ * table overflows, for_each() falls back to probing all buses.
+ */
+class Pci_devices
+{
+public:
+  enum { Max_devs = 1024 };
+
+  template<typename F>
+  static void for_each(F &&f)
+  {
+    if (!_scanned)
+      scan();
+
+    if (_num > Max_devs)
+      for (Pci_iterator i; i != Pci_iterator::end(); ++i)
+        f(i);
+    else
+      for (unsigned n = 0; n < _num; ++n)
+        f(_devs[n]);
+  }
+
+  /**
+   * Set known root buses, e.g. of several sockets, in addition to the first
+   * bus.
+   *
+   * \param buses  Bitmap of the root buses, might be incomplete.
+   */
+  static void set_root_buses(l4_uint32_t const *buses)
+  {
+    for (unsigned i = 0; i < Pci_iterator::Max_bus / 32; ++i)
+      _roots[i] = buses[i];
+  }
+
+private:
+  enum
+  {
+    Hdr_type     = 0xe,
+    Secondary    = 0x19,
+    Subordinate  = 0x1a,
+    Hdr_multi_fn = 0x80,
+    Hdr_bridge   = 1,
+    Hdr_cardbus  = 2,
+  };
+
+  static void scan()
+  {
+    _scanned = true;
+    _num = 0;
+
+    unsigned first = pci_ecam.base ? pci_ecam.start_bus : 0;
+    unsigned last = pci_ecam.base ? pci_ecam.end_bus : Pci_iterator::Max_bus - 1;
+    scan_bus(first);
+
+    for (unsigned bus = first + 1; bus <= last; ++bus)
+      if (_roots[bus / 32] & (1U << (bus % 32)))
+        scan_bus(bus);
+
+    // Look for host bridges of further root buses, e.g. of other sockets
+    for (unsigned bus = first + 1; bus <= last; ++bus)
+      if (!(_reached[bus / 32] & (1U << (bus % 32))))
+        for (unsigned dev = 0; dev < 32; ++dev)
+          if (::pci_read(bus, dev, 0, 0, 32) != 0xffffffffU)
+            {
+              scan_bus(bus);
+              break;
+            }
+
+    if (_num > Max_devs)
+      {
+        printf("PCI: More than %u functions, probing all buses.\n",
+               (unsigned)Max_devs);
+        return;
+      }
+
+    // Keep the bus/device/function order, e.g. for -comport=pci:<card>
+    for (unsigned i = 1; i < _num; ++i)
+      {
+        Pci_iterator d = _devs[i];
+        unsigned j = i;
+        for (; j > 0 && key(_devs[j - 1]) > key(d); --j)
+          _devs[j] = _devs[j - 1];
+        _devs[j] = d;
+      }
+  }
+
+  static void scan_bus(unsigned bus)
+  {
+    if (bus >= Pci_iterator::Max_bus || (_reached[bus / 32] & (1U << (bus % 32))))
+      return;
+
+    _reached[bus / 32] |= 1U << (bus % 32);
+
+    for (unsigned dev = 0; dev < 32; ++dev)
+      for (unsigned func = 0; func < 8; ++func)
+        {
+          l4_uint32_t vd = ::pci_read(bus, dev, func, 0, 32);
+          if (vd == 0xffffffffU)
+            {
+              if (func == 0)
+                break;
+              continue;
+            }
+
+          unsigned char hdr = ::pci_read(bus, dev, func, Hdr_type, 8);
+          if (_num < Max_devs)
+            {
+              _devs[_num] = Pci_iterator(bus, dev, func);
+              _devs[_num].vd = vd;
+            }
+          ++_num;
+
+          unsigned type = hdr & ~Hdr_multi_fn;
+          if (type == Hdr_bridge || type == Hdr_cardbus)
+            {
+              unsigned sec = ::pci_read(bus, dev, func, Secondary, 8);
+              unsigned sub = ::pci_read(bus, dev, func, Subordinate, 8);
+              // Bridges not configured by the firmware have no buses
+              if (sec > bus && sec <= sub)
+                scan_bus(sec);
+            }
+
+          if (func == 0 && !(hdr & Hdr_multi_fn))
+            break;
+        }
+  }
+
+  static unsigned key(Pci_iterator const &d)
+  { return (d.bus << 8) | (d.dev << 3) | d.func; }
+
+  static inline Pci_iterator _devs[Max_devs];
+  static inline unsigned _num;
+  static inline bool _scanned;
+  static inline l4_uint32_t _reached[Pci_iterator::Max_bus / 32];
+  static inline l4_uint32_t _roots[Pci_iterator::Max_bus / 32];
+};
+
+/**
+ * Use the memory-mapped configuration space of PCI segment 0 as described in
+ * the ACPI MCFG table, if any, and get the PCI root buses from the DSDT and
+ * SSDTs.
+ *
+ * \param rsdp  ACPI RSDP, may be nullptr.
+ * \param map   Makes the configuration space accessible, returns false if
+ *              it cannot be accessed.
+ */
+template<typename MAP>
+static void
+pci_init_ecam(void *rsdp, MAP &&map)
+{
+  Acpi::Sdt sdt;
+  if (!rsdp || !sdt.init(rsdp))
+    return;
+
+  if (Acpi::Table_head const *dsdt = sdt.dsdt())
+    {
+      l4_uint32_t buses[Pci_iterator::Max_bus / 32] = { 0 };
+      Acpi::pci_root_buses(dsdt, buses);
+      sdt.for_each("SSDT", [&](Acpi::Table_head const *ssdt)
+        { Acpi::pci_root_buses(ssdt, buses); });
+      Pci_devices::set_root_buses(buses);
+    }
+
+  auto const *mcfg = sdt.find<Acpi::Mcfg const *>("MCFG");
+  if (!mcfg)
+    return;
+
+  for (unsigned i = 0; i < mcfg->num_entries(); ++i)
+    {
+      Acpi::Mcfg::Entry const &e = mcfg->entries[i];
+      if (e.segment != 0 || e.start_bus > e.end_bus)
+        continue;
+
+      l4_uint64_t start = e.base + (l4_uint64_t{e.start_bus} << 20);
+      l4_uint64_t size = l4_uint64_t{e.end_bus - e.start_bus + 1U} << 20;
+      if (!map(start, size))
+        return;
+
+      pci_ecam.base = e.base;
+      pci_ecam.start_bus = e.start_bus;
+      pci_ecam.end_bus = e.end_bus;
+      log_verbose("PCI: ECAM at %llx, buses %02x-%02x\n",
+                  start, e.start_bus, e.end_bus);
+      return;
+    }
+}
+
 #if 0
       if (classcode == 0x06 && subclass == 0x04)
         buses++;
@@ -368,7 +601,7 @@ struct Pci_iterator
 
 
 
-struct Bs_uart : L4::Uart_16550
+struct Bs_uart : Uart_16550_fifo
 {
   union Regs
   {
@@ -381,7 +614,7 @@ struct Bs_uart : L4::Uart_16550
   Regs uart_regs;
 
   Bs_uart(Serial_board *board, unsigned port, unsigned long baudrate)
-  : L4::Uart_16550(board->base_baud, 0, 0, 0x8 /* out2 */, 0), ok(false)
+  : Uart_16550_fifo(board->base_baud, 0, 0, 0x8 /* out2 */, 0), ok(false)
   {
     type = board->get_type();
     if (type == Resource::IO_BAR)
@@ -760,60 +993,47 @@ Pci_com_dev _devs[] = {
 enum { Num_known_devs = sizeof(_devs) / sizeof(_devs[0]) };
 
 
-static Pci_iterator
-_search_pci_serial_devs(Pci_iterator const &begin, Pci_iterator const &end,
-                        Serial_board *board, bool print)
+static bool
+setup_pci_serial_dev(Pci_iterator const &i, Serial_board *board)
 {
-  for (Pci_iterator i = begin; i != end; ++i)
-    {
-      if (print)
-        {
-          printf("\r%02x:%02x.%1x Class %02x.%02x Prog %02x: %04x:%04x",
-                 i.bus, i.dev, i.func, i.classcode(), i.subclass(), i.prog(),
-                 i.vendor(), i.device());
-          fflush(stdout);
-        }
+  for (unsigned d = 0; d < Num_known_devs; ++d)
+    if ((i.vendor_device() & _devs[d].mask) == _devs[d].vendor_device
+        && _devs[d].driver->setup(i, board))
+      return true;
 
-      for (unsigned d = 0; d < Num_known_devs; ++d)
-        if ((i.vendor_device() & _devs[d].mask) == _devs[d].vendor_device
-            && _devs[d].driver->setup(i, board))
-          return i;
-    }
-
-  if (print)
-    putchar('\r');
-
-  return end;
+  return false;
 }
 
 static unsigned long
 search_pci_serial_devs(int card_idx, Serial_board *board)
 {
-  Pci_iterator end = Pci_iterator::end();
-  Pci_iterator i;
-  for (int card = 0; i != end; ++i, ++card) {
-    i = _search_pci_serial_devs(i, end, board, false);
-    if (card == card_idx)
-      return 1;
-  }
+  int card = 0;
+  bool found = false;
+  Pci_devices::for_each([&](Pci_iterator const &i)
+    {
+      if (!found && setup_pci_serial_dev(i, board))
+        found = card++ == card_idx;
+    });
 
-  return 0;
+  return found;
 }
 
 [[noreturn]] static void
 scan_pci_uarts(Dual_uart *du, unsigned long baudrate)
 {
-  Serial_board board;
-  Pci_iterator end = Pci_iterator::end();
+  int card = 0;
   // classes should be 7:0
-  Pci_iterator i;
   printf("Scanning for PCI UARTS...\n");
-  for (int card = 0; i != end; ++i, ++card)
+  Pci_devices::for_each([&](Pci_iterator const &i)
     {
-      i = _search_pci_serial_devs(i, end, &board, true);
+      printf("\r%02x:%02x.%1x Class %02x.%02x Prog %02x: %04x:%04x",
+             i.bus, i.dev, i.func, i.classcode(), i.subclass(), i.prog(),
+             i.vendor(), i.device());
+      fflush(stdout);
 
-      if (i == end)
-        break;
+      Serial_board board;
+      if (!setup_pci_serial_dev(i, &board))
+        return;
 
       for (unsigned p = 0; p < board.num_ports; ++p)
         {
@@ -827,7 +1047,9 @@ scan_pci_uarts(Dual_uart *du, unsigned long baudrate)
                  i.bus, i.dev, i.func, card, p);
           du->set_uart2(0);
         }
-    }
+      ++card;
+    });
+  putchar('\r');
   printf("Done scanning for PCI UARTs. Please reset or power-off.");
   fflush(stdout);
   l4_infinite_loop();
@@ -1072,10 +1294,30 @@ public:
       }
   }
 
+  /**
+   * Make physical memory, e.g. PCI configuration space, accessible.
+   *
+   * \retval false  The memory cannot be accessed.
+   */
+  virtual bool map_phys(l4_uint64_t addr, l4_uint64_t size)
+  { return addr + size == (unsigned long)(addr + size); }
+
+  /**
+   * Set up PCI configuration space access, call before any PCI access.
+   *
+   * \param rsdp  ACPI RSDP to look for memory-mapped configuration space,
+   *              may be nullptr.
+   */
+  void init_pci(void *rsdp)
+  {
+    pci_init_ecam(rsdp, [this](l4_uint64_t addr, l4_uint64_t size)
+      { return map_phys(addr, size); });
+  }
+
   // disable bus mastering for every found PCI device
   void disable_pci_bus_master()
   {
-    for (Pci_iterator i; i != Pci_iterator::end(); ++i)
+    Pci_devices::for_each([](Pci_iterator const &i)
       {
         // Until the handoff protocol for the Xhci controller went through,
         // the firmware might use it. Disabling DMA at this time might cause
@@ -1083,8 +1325,8 @@ public:
         // bus master until after xhci handoff.
         unsigned cc = i.pci_class();
         if (cc == PCI_CLASS_SERIAL_USB_XHCI)
-          continue;
+          return;
         i.disable_bus_master();
-      }
+      });
   }
 };
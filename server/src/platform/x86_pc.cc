@@ -150,6 +150,43 @@ struct Platform_x86_1 : Platform_x86
     regions->add(Region::start_size(0UL, 0x1000, ".BIOS", Region::Arch));
   }
 
+#ifdef ARCH_amd64
+  bool map_phys(l4_uint64_t addr, l4_uint64_t size) override
+  {
+    // Page tables cannot be allocated before the memory map is known, only
+    // the initial identity mapping of boot32 is usable.
+    return addr + size <= boot32_info->mem_end + 1;
+  }
+
+  /**
+   * Identity map the RAM beyond the initial mapping of boot32.
+   *
+   * boot32 maps at most the first 4 GiB. Mapping the remaining RAM allows
+   * moving and decompressing modules into high memory.
+   */
+  void map_upper_ram() override
+  {
+    l4_uint64_t end = mem_end;
+    for (Region const &r : *mem_manager->ram)
+      {
+        if (r.end() <= mem_end)
+          continue;
+
+        l4_uint64_t begin = r.begin() > mem_end ? r.begin() : mem_end + 1;
+        ptab_map_range(boot32_info->ptab64_addr, begin, begin,
+                       r.end() - begin + 1, PTAB_WRITE | PTAB_USER);
+        if (r.end() > end)
+          end = r.end();
+      }
+
+    if (end == mem_end)
+      return;
+
+    log_verbose("  Mapped RAM %llx-%llx\n", mem_end + 1, end);
+    mem_end = end;
+  }
+#endif
+
   void late_setup(l4_kernel_info_t *kip) override
   {
     if (rsdp_start)
@@ -316,12 +353,31 @@ public:
                   static_cast<unsigned long>(mod->mod_start));
     _move_module(index, dest, src, size, name, type, subtype);
 
-    assert ((l4_addr_t)dest < 0xfffffff0);
-    assert ((l4_addr_t)dest < 0xfffffff0 - size);
     mod->mod_start = (l4_addr_t)dest;
     mod->mod_end   = (l4_addr_t)dest + size;
   }
 
+  /**
+   * Check whether the boot loader placed the modules such that they can be
+   * used without moving them.
+   *
+   * The modules must be page-aligned (GRUB aligns them on request, see
+   * mb2.S) and located behind `mod_addr`. Collisions with the ELF regions
+   * are excluded already because the modules are reserved since
+   * init_regions().
+   */
+  bool modules_in_place(unsigned long mod_addr) const
+  {
+    auto *mods = reinterpret_cast<l4util_l4mod_mod const *>(
+                   static_cast<unsigned long>(l4mi->mods_addr));
+    for (unsigned i = 0; i < l4mi->mods_count; ++i)
+      if (mods[i].mod_start < mod_addr
+          || mods[i].mod_start & (L4_PAGESIZE - 1))
+        return false;
+
+    return true;
+  }
+
   /* Not used in image mode */
   l4util_l4mod_info *construct_mbi(unsigned long mod_addr,
                                    Internal_module_list const &) override
@@ -452,7 +508,21 @@ public:
         return strcmp(r->name(), ".mbi") == 0;
       });
 
-    move_modules(mod_addr);
+    if (modules_in_place(mod_addr))
+      {
+        // Just turn the module regions into their final regions
+        log_verbose("  Using %u modules in place\n", l4mi->mods_count);
+        mem_manager->regions->remove_if([](Region const *r)
+          {
+            return r->name() == Mod_info::Mod_reg;
+          });
+
+        for (unsigned i = 0; i < l4mi->mods_count; ++i)
+          move_module(i, reinterpret_cast<void *>(
+                           static_cast<l4_addr_t>(l4m_mods[i].mod_start)));
+      }
+    else
+      move_modules(mod_addr);
 
     return l4mi;
   }
@@ -641,7 +711,7 @@ xhci_handoff(Pci_iterator const &dev)
 static void
 pci_quirks()
 {
-  for (Pci_iterator i; i != Pci_iterator::end(); ++i)
+  Pci_devices::for_each([](Pci_iterator const &i)
     {
       unsigned cc = i.pci_class();
       if (cc == PCI_CLASS_SERIAL_USB_XHCI)
@@ -649,7 +719,7 @@ pci_quirks()
           xhci_handoff(i);
           i.disable_bus_master();
         }
-    }
+    });
 }
 
 extern "C"
@@ -679,6 +749,12 @@ void __main(l4util_mb_info_t *mbi, unsigned long p2, char const *realmode_si,
   if (!cmdline)
     cmdline = mod_header->mbi_cmdline();
 
+#ifdef ARCH_amd64
+  _x86_pc_platform.init_pci(reinterpret_cast<void *>(boot32_info->rsdp_start));
+#else
+  _x86_pc_platform.init_pci(nullptr);
+#endif
+
   static Uart_vga vga_uart;
   _x86_pc_platform.setup_uart(cmdline, &vga_uart);
   _x86_pc_platform.disable_pci_bus_master();
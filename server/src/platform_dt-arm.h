@@ -8,9 +8,15 @@
 
 #pragma once
 
+#include "mp_workers.h"
 #include "platform-arm.h"
 #include "platform_dt.h"
 #include "support.h"
+#include "timestamp.h"
+
+#ifdef ARCH_arm64
+#include "ARCH-arm64/mmu.h"
+#endif
 
 class Platform_dt_arm : public Platform_dt<Platform_arm>
 {
@@ -44,7 +50,14 @@ public:
     return interrupts.get(0, 1) + (gic_type == 0 ? 32 : 0);
   }
 
-  void query_psci_method()
+  /**
+   * Find the PSCI node in the device tree.
+   *
+   * \param[out] method  Conduit to invoke PSCI functions.
+   *
+   * \return The PSCI node, invalid if there is none.
+   */
+  Dt::Node psci_node(Psci_method *method) const
   {
     Dt::Node psci = dt.node_by_compatible("arm,psci-1.0");
     if (!psci.is_valid())
@@ -52,20 +65,182 @@ public:
     if (!psci.is_valid())
       psci = dt.node_by_compatible("arm,psci");
 
-    set_psci_method(Psci_unsupported);
+    *method = Psci_unsupported;
 
     if (psci.is_valid())
       {
-        const char *method = psci.get_prop_str("method");
-        if (method && !strcmp(method, "smc"))
-          set_psci_method(Psci_smc);
-        else if (method && !strcmp(method, "hvc"))
-          set_psci_method(Psci_hvc);
+        const char *m = psci.get_prop_str("method");
+        if (m && !strcmp(m, "smc"))
+          *method = Psci_smc;
+        else if (m && !strcmp(m, "hvc"))
+          *method = Psci_hvc;
       }
+
+    return psci;
+  }
+
+  void query_psci_method()
+  {
+    Psci_method method;
+    psci_node(&method);
+    set_psci_method(method);
   }
 
+#ifdef ARCH_arm64
+  /**
+   * Start all other CPUs announced with the "psci" enable method via CPU_ON.
+   *
+   * The workers run in the same cache state as the boot CPU: with MMU and
+   * caches disabled, or with the identity mapping of mmu_enable_identity().
+   * They are not started if someone else enabled the caches of the boot CPU,
+   * otherwise they would not see what the boot CPU has in its data cache.
+   */
+  unsigned start_workers(unsigned max_slots) override
+  {
+    if (!dt.have_fdt())
+      return 0;
+
+    if (!mmu_prepare_workers())
+      {
+        log_info("  Caches enabled by firmware, not starting other CPUs.\n");
+        return 0;
+      }
+
+    // PSCI 0.1 has no standard function IDs
+    Psci_method method;
+    Dt::Node psci = psci_node(&method);
+    if (method == Psci_unsupported
+        || !(   psci.check_compatible("arm,psci-1.0")
+             || psci.check_compatible("arm,psci-0.2")))
+      return 0;
+
+    Dt::Node cpus = dt.node_by_path("/cpus");
+    if (!cpus.is_valid())
+      return 0;
+
+    l4_uint64_t self;
+    asm ("mrs %0, MPIDR_EL1" : "=r"(self));
+    self &= Mpidr_aff_mask;
+
+    extern char mp_worker_psci_entry[];
+    extern l4_uint32_t mp_worker_psci_hvc;
+    mp_worker_psci_hvc = method == Psci_hvc;
+    Cache::Data::clean(reinterpret_cast<unsigned long>(&mp_worker_psci_hvc),
+                       sizeof(mp_worker_psci_hvc));
+    _worker_psci = method;
+    l4_uint64_t entry
+      = to_phys(reinterpret_cast<l4_addr_t>(mp_worker_psci_entry));
+
+    unsigned slot = 0;
+    _worker_slots = 0;
+    cpus.for_each_subnode([&](Dt::Node cpu)
+      {
+        if (slot >= max_slots || slot >= Mp_workers::Max_workers)
+          return Dt::Break;
+
+        if (!cpu.check_device_type("cpu") || !cpu.is_enabled()
+            || !cpu.stringlist_contains("enable-method", "psci"))
+          return Dt::Continue;
+
+        l4_uint64_t mpidr;
+        if (!cpu.get_reg(0, &mpidr) || mpidr == self)
+          return Dt::Continue;
+
+        int r = psci_call(method, Psci_cpu_on, mpidr, entry, slot);
+        if (r == 0)
+          {
+            _worker_mpidr[slot] = mpidr;
+            _worker_slots |= 1U << slot;
+          }
+        else
+          cpu.warn("PSCI CPU_ON failed: %d\n", r);
+
+        ++slot;
+        return Dt::Continue;
+      });
+
+    return _worker_slots;
+  }
+
+  void stop_workers() override
+  {
+    // The kernel's CPU_ON fails unless CPU_OFF has completed. Do not hang if
+    // the firmware never reports it.
+    l4_uint64_t freq = timestamp_freq();
+    l4_uint64_t t = timestamp();
+    for (unsigned i = 0; i < Mp_workers::Max_workers; ++i)
+      if (_worker_slots & (1U << i))
+        for (unsigned long loops = 0;; ++loops)
+          {
+            int r = psci_call(_worker_psci, Psci_affinity_info,
+                              _worker_mpidr[i], 0);
+            if (r == Psci_affinity_off)
+              break;
+
+            if (r < 0)
+              {
+                log_warn("  PSCI: AFFINITY_INFO for CPU %llx failed: %d\n",
+                         _worker_mpidr[i], r);
+                break;
+              }
+
+            if (freq ? timestamp_to_us(timestamp() - t) > Cpu_off_timeout_us
+                     : loops > Cpu_off_timeout_loops)
+              {
+                log_warn("  PSCI: CPU %llx did not turn off.\n",
+                         _worker_mpidr[i]);
+                break;
+              }
+          }
+
+    _worker_slots = 0;
+  }
+#endif
+
   void set_dtb_in_kip(l4_kernel_info_t *kip)
   {
     kip->dt_addr = reinterpret_cast<l4_umword_t>(dt.fdt());
   }
+
+#ifdef ARCH_arm64
+private:
+  enum : unsigned long
+  {
+    Psci_cpu_on        = 0xc4000003,
+    Psci_affinity_info = 0xc4000004,
+    Mpidr_aff_mask     = 0xff00ffffffUL,
+  };
+
+  enum { Psci_affinity_off = 1 };
+
+  enum
+  {
+    // Give the worker CPUs this long to turn off
+    Cpu_off_timeout_us = 100000,
+    Cpu_off_timeout_loops = 50000000,
+  };
+
+  static int psci_call(Psci_method method, unsigned long func,
+                       unsigned long a1, unsigned long a2,
+                       unsigned long a3 = 0)
+  {
+    register unsigned long r0 asm("x0") = func;
+    register unsigned long r1 asm("x1") = a1;
+    register unsigned long r2 asm("x2") = a2;
+    register unsigned long r3 asm("x3") = a3;
+    if (method == Psci_hvc)
+      asm volatile ("hvc #0" : "+r"(r0), "+r"(r1), "+r"(r2), "+r"(r3)
+                    : : "x4", "x5", "x6", "x7", "x8", "x9", "x10", "x11",
+                        "x12", "x13", "x14", "x15", "x16", "x17", "memory");
+    else
+      asm volatile ("smc #0" : "+r"(r0), "+r"(r1), "+r"(r2), "+r"(r3)
+                    : : "x4", "x5", "x6", "x7", "x8", "x9", "x10", "x11",
+                        "x12", "x13", "x14", "x15", "x16", "x17", "memory");
+    return static_cast<int>(r0);
+  }
+
+  Psci_method _worker_psci = Psci_unsupported;
+  unsigned _worker_slots = 0;
+  l4_uint64_t _worker_mpidr[Mp_workers::Max_workers];
+#endif
 };
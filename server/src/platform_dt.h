@@ -5,9 +5,14 @@
  * License: see LICENSE.spdx (in this directory or the directories above)
  */
 
+#include <stdio.h>
+
 #include "boot_modules.h"
 #include "dt.h"
+#include "memory.h"
 #include "platform.h"
+#include "startup.h"
+#include "support.h"
 
 template<typename BASE>
 class Platform_dt : public BASE,
@@ -28,7 +33,22 @@ class Platform_dt : public BASE,
     Dt const &dt;
   };
 
+  struct Summary_module : Internal_module_base
+  {
+    Summary_module() : Internal_module_base(".platsum") {}
+
+    void set_region(l4util_l4mod_mod *m) const override
+    {
+      m->mod_start = addr;
+      m->mod_end   = addr + size;
+    }
+
+    l4_addr_t addr = 0;
+    unsigned long size = 0;
+  };
+
   Dt_module mod_fdt;
+  Summary_module mod_summary;
 
 public:
   Platform_dt() : mod_fdt(".fdt", dt) {}
@@ -54,5 +74,55 @@ public:
       mods.push_front(&mod_fdt);
   }
 
+  void compact_dt() override
+  {
+    if (!dt.have_fdt())
+      return;
+
+    unsigned long size = l4_round_page(dt.compact_buffer_size());
+    unsigned long addr = mem_manager->find_free_ram(size);
+    // The device tree itself is usually not covered by a region
+    Region old = Region::start_size(dt.fdt(), dt.fdt_size());
+    if (addr && Region::start_size(addr, size).overlaps(old))
+      addr = mem_manager->find_free_ram(size, old.end() + 1);
+    if (!addr)
+      {
+        printf("  Could not allocate memory for the compacted device tree.\n");
+        return;
+      }
+
+    unsigned long old_size = dt.fdt_size();
+    unsigned long new_size = dt.compact(reinterpret_cast<void *>(addr), size);
+    if (!new_size)
+      return;
+
+    mem_manager->regions->add(Region::start_size(addr, l4_round_page(new_size),
+                                                  ".fdt", Region::Root));
+    dt.init(addr);
+    log_info("  Compacted device tree from %lu to %lu bytes.\n",
+             old_size, new_size);
+  }
+
+  void add_platform_summary(Internal_module_list &mods) override
+  {
+    if (!dt.have_fdt())
+      return;
+
+    unsigned long size = dt.write_summary(nullptr, 0, kuart, kuart_flags);
+    unsigned long addr = mem_manager->find_free_ram(l4_round_page(size));
+    if (!addr)
+      {
+        printf("  Could not allocate memory for the platform summary.\n");
+        return;
+      }
+
+    mem_manager->regions->add(Region::start_size(addr, l4_round_page(size),
+                                                  ".platsum", Region::Root));
+    dt.write_summary(reinterpret_cast<void *>(addr), size, kuart, kuart_flags);
+    mod_summary.addr = addr;
+    mod_summary.size = size;
+    mods.push_front(&mod_summary);
+  }
+
   Dt dt;
 };
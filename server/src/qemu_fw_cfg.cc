@@ -12,37 +12,13 @@
 #include <l4/cxx/utils>
 #include <l4/sys/compiler.h>
 
+#include "io_barrier.h"
 #include "panic.h"
 #include "qemu_fw_cfg.h"
 
 namespace
 {
 
-/// Enforces ordering between MMIO register access and/or shared memory accesses.
-#if defined(__ARM_ARCH) && (__ARM_ARCH == 5 || __ARM_ARCH == 6)
-static inline void mb() { asm volatile("mcr p15, 0, %0, c7, c10, 4" : : "r" (0) : "memory"); }
-#elif defined(__ARM_ARCH) && __ARM_ARCH == 7
-static inline void mb() { asm volatile ("dsb" : : : "memory"); }
-#elif defined(__ARM_ARCH) && __ARM_ARCH >= 8
-// Since ARMv8 the memory model is other-multi-copy atomic, i.e. a memory write
-// observed by an observer is also visible to all other observers. In other
-// words, the memory write is either visible only locally to the originator (for
-// example, in its store buffer) or visible globally to all observers, i.e. it
-// is propagated to all observers at the same time.
-// Therefore, an dmb is sufficient to ensure that not only the CPU and device
-// agree on the order of MMIO register accesses and shared memory accesses, but
-// also a potential DMA master via which the device performs DMA operations.
-static inline void mb() { asm volatile ("dmb osh" : : : "memory"); }
-#elif defined(__mips__)
-static inline void mb() { asm volatile ("sync" : : : "memory"); }
-#elif defined(__amd64__) || defined(__i386__) || defined(__i686__)
-static inline void mb() { asm volatile ("mfence" : : : "memory"); }
-#elif defined(__riscv)
-static inline void mb() { asm volatile ("fence iorw, iorw" : : : "memory"); }
-#else
-#error Missing proper memory write barrier
-#endif
-
 enum Fw_cfg_item_slectors
 {
   // Item selectors defined by Qemu
@@ -102,6 +78,35 @@ static_assert(sizeof(Fw_cfg_dir) == 4, "Unexpected dir size.");
 
 bool _fw_cfg_present = false;
 
+/**
+ * Copy of the file directory, read once during initialization.
+ *
+ * QEMU provides 32 file slots by default, the table leaves room for machines
+ * with more. Larger directories are searched on the device.
+ */
+enum
+{
+  Max_files  = 64,
+  Hash_slots = 2 * Max_files,
+};
+
+Fw_cfg_file _files[Max_files];
+l4_uint32_t _num_files;
+bool _files_cached = false;
+
+/// Index + 1 of the file in `_files`, 0 for an empty slot
+l4_uint8_t _file_hash[Hash_slots];
+
+unsigned
+name_hash(char const *name)
+{
+  // FNV-1a
+  l4_uint32_t h = 2166136261U;
+  for (unsigned i = 0; i < sizeof(Fw_cfg_file::name) && name[i]; ++i)
+    h = (h ^ static_cast<unsigned char>(name[i])) * 16777619U;
+  return h % Hash_slots;
+}
+
 }
 
 bool
@@ -123,9 +128,34 @@ Fw_cfg::init()
   if (!(features & Fw_cfg_version_dma_supported))
     panic("fw_cfg: Does not support DMA interface.");
 
+  read_dir();
   return true;
 }
 
+void
+Fw_cfg::read_dir()
+{
+  select(Fw_cfg_file_dir);
+
+  _num_files = be32toh(read<l4_uint32_t>());
+  if (_num_files > Max_files)
+    return;
+
+  read_bytes(_num_files * sizeof(Fw_cfg_file),
+             reinterpret_cast<l4_uint8_t *>(_files));
+
+  for (l4_uint32_t i = 0; i < _num_files; ++i)
+    {
+      _files[i].name[sizeof(_files[i].name) - 1] = 0;
+      unsigned h = name_hash(_files[i].name);
+      while (_file_hash[h])
+        h = (h + 1) % Hash_slots;
+      _file_hash[h] = i + 1;
+    }
+
+  _files_cached = true;
+}
+
 bool
 Fw_cfg::is_present()
 {
@@ -135,21 +165,40 @@ Fw_cfg::is_present()
 bool
 Fw_cfg::find_file(char const *name, l4_uint16_t *selector, l4_uint32_t *size)
 {
-  select(Fw_cfg_file_dir);
+  Fw_cfg_file const *found = nullptr;
+  Fw_cfg_file file;
 
-  Fw_cfg_dir dir = read<Fw_cfg_dir>();
-  for(l4_uint32_t i = 0; i < be32toh(dir.count); i++)
+  if (_files_cached)
+    {
+      for (unsigned h = name_hash(name); _file_hash[h]; h = (h + 1) % Hash_slots)
+        if (!strncmp(_files[_file_hash[h] - 1].name, name, sizeof(file.name)))
+          {
+            found = &_files[_file_hash[h] - 1];
+            break;
+          }
+    }
+  else
     {
-      Fw_cfg_file file = read<Fw_cfg_file>();
-      if (!strncmp(file.name, name, sizeof(file.name)))
+      select(Fw_cfg_file_dir);
+
+      Fw_cfg_dir dir = read<Fw_cfg_dir>();
+      for(l4_uint32_t i = 0; i < be32toh(dir.count); i++)
         {
-          if (selector) *selector = be16toh(file.select);
-          if (size) *size = be32toh(file.size);
-          return true;
+          file = read<Fw_cfg_file>();
+          if (!strncmp(file.name, name, sizeof(file.name)))
+            {
+              found = &file;
+              break;
+            }
         }
     }
 
-  return false;
+  if (!found)
+    return false;
+
+  if (selector) *selector = be16toh(found->select);
+  if (size) *size = be32toh(found->size);
+  return true;
 }
 
 l4_uint32_t
@@ -211,7 +260,7 @@ Fw_cfg::dma_transfer(l4_uint32_t control, l4_uint32_t size, l4_uint8_t *buffer)
 
   // The data in the buffer and the access descriptor must be visible before
   // starting the DMA transfer.
-  mb();
+  io_mb();
 
   trigger_dma(reinterpret_cast<l4_addr_t>(&access));
 
@@ -224,5 +273,5 @@ Fw_cfg::dma_transfer(l4_uint32_t control, l4_uint32_t size, l4_uint8_t *buffer)
     }
 
   // Ensure the transferred data is visible.
-  mb();
+  io_mb();
 }
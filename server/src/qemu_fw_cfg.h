@@ -45,6 +45,9 @@ public:
   /**
    * Lookup firmware configuration item by path name.
    *
+   * Uses the copy of the file directory read during initialization unless
+   * the directory is too large for it.
+   *
    * \param      name      Path name of the configuration item to lookup.
    * \param[out] selector  Selector of the configuration item, if found.
    * \param[out] size      Size of the configuration item, if found.
@@ -118,6 +121,7 @@ public:
 
 private:
   static bool init();
+  static void read_dir();
   static void dma_transfer(l4_uint32_t control, l4_uint32_t size, l4_uint8_t *buffer);
   static void trigger_dma(l4_addr_t dma_desc);
 };
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <l4/sys/consts.h>
+
+#include "memory.h"
+#include "panic.h"
+#include "qemu_fw_cfg.h"
+#include "qemu_fw_cfg_modules.h"
+#include "qemu_ramfb.h"
+#include "support.h"
+
+bool
+Boot_modules_fw_cfg::probe()
+{
+  if (_probed)
+    return _num_mods > 0;
+
+  _probed = true;
+
+  if (!Fw_cfg::is_present())
+    return false;
+
+  l4_uint32_t size = Fw_cfg::select_file("opt/org.l4re/modules");
+  if (!size)
+    return false;
+
+  if (size >= sizeof(_list))
+    panic("fw_cfg: Module list too large (%u bytes).", size);
+
+  Fw_cfg::read_bytes(size, reinterpret_cast<l4_uint8_t *>(_list));
+  _list[size] = 0;
+
+  parse_list();
+
+  for (unsigned i = 0; i < _num_mods; ++i)
+    {
+      l4_uint16_t selector;
+      l4_uint32_t mod_size;
+      if (!Fw_cfg::find_file(_mods[i].name, &selector, &mod_size))
+        panic("fw_cfg: Module '%s' not found.", _mods[i].name);
+      if (mod_size == 0)
+        panic("fw_cfg: Module '%s' empty, modules must not have zero size.",
+              _mods[i].name);
+      _mods[i].size = mod_size;
+    }
+
+  if (_num_mods)
+    log_info("  Using %u modules from fw_cfg.\n", _num_mods);
+
+  return _num_mods > 0;
+}
+
+/**
+ * Transfer a module to its destination and reserve the memory.
+ *
+ * The remaining bytes of the last page are filled with zeros.
+ */
+void
+Boot_modules_fw_cfg::load(unsigned index, l4_addr_t addr, Region::Type type)
+{
+  Mod const &m = _mods[index];
+  char *dest = reinterpret_cast<char *>(addr);
+
+  log_verbose("  fw_cfg: Loading module %02u to %lx (%lu bytes): %s\n",
+              index, addr, m.size, m.cmdline);
+
+  // The directory lookup is cached, so there is no need to keep the selector
+  l4_uint16_t selector;
+  l4_uint32_t size;
+  Fw_cfg::find_file(m.name, &selector, &size);
+  Fw_cfg::select(selector);
+  Fw_cfg::read_bytes(m.size, reinterpret_cast<l4_uint8_t *>(dest));
+  memset(dest + m.size, 0, l4_round_page(m.size) - m.size);
+
+  add_region(index, addr, m.size, type);
+}
+
+void
+Boot_modules_fw_cfg::init_mod_regions()
+{
+  // The kernel, sigma0 and the root task must be readable for placing their
+  // ELF regions. Keep them at the end of the RAM, away from the usual link
+  // addresses.
+  for (unsigned i = 0; i < Num_base_mods && i < _num_mods; ++i)
+    {
+      l4_addr_t addr = mem_manager->find_free_ram_rev(l4_round_page(_mods[i].size));
+      if (!addr)
+        panic("fw_cfg: Could not allocate %lu bytes for module %u.",
+              _mods[i].size, i);
+      load(i, addr, Region::Boot);
+    }
+}
+
+void
+Boot_modules_fw_cfg::move_module(unsigned index, void *dest)
+{
+  if (!_mods[index].addr)
+    {
+      load(index, reinterpret_cast<l4_addr_t>(dest), Region::Root);
+      return;
+    }
+
+  Boot_modules_list::move_module(index, dest);
+}
+
+l4util_l4mod_info *
+Boot_modules_fw_cfg::construct_mbi(unsigned long mod_addr,
+                                   Internal_module_list const &internal_mods)
+{
+  // Transfer the remaining modules in one contiguous range
+  unsigned long total_size = 0;
+  for (unsigned i = Num_base_mods; i < _num_mods; ++i)
+    total_size += l4_round_page(_mods[i].size);
+
+  if (total_size)
+    {
+      l4_addr_t to = mem_manager->find_free_ram(total_size, mod_addr);
+      if (!to)
+        {
+          log_error("Need %lx bytes above %lx:\n", total_size, mod_addr);
+          mem_manager->ram->dump();
+          mem_manager->regions->dump();
+          panic("Could not find free RAM region for modules!");
+        }
+
+      for (unsigned i = Num_base_mods; i < _num_mods; ++i)
+        {
+          load(i, to, Region::Root);
+          to += l4_round_page(_mods[i].size);
+        }
+    }
+
+  l4util_l4mod_info *mbi = build_mbi(mod_addr, internal_mods);
+  setup_ramfb(mbi);
+  return mbi;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include "boot_modules.h"
+
+/**
+ * Boot modules provided as QEMU fw_cfg files.
+ *
+ * The fw_cfg item `opt/org.l4re/modules` lists one module per line: the name
+ * of the fw_cfg item holding the module, followed by the command line of the
+ * module. As with multiboot, the first three modules are the kernel, sigma0
+ * and the root task. For example:
+ *
+ *     -fw_cfg opt/org.l4re/modules,file=modules.txt
+ *     -fw_cfg opt/org.l4re/fiasco,file=fiasco
+ *     -fw_cfg opt/org.l4re/sigma0,file=sigma0
+ *     ...
+ *
+ * with `modules.txt` containing:
+ *
+ *     opt/org.l4re/fiasco fiasco -serial_esc
+ *     opt/org.l4re/sigma0 sigma0
+ *     opt/org.l4re/moe moe rom/hello.cfg
+ *     opt/org.l4re/hello.cfg rom/hello.cfg
+ *
+ * The payloads are transferred by DMA directly to their final location, the
+ * kernel, sigma0 and the root task when the regions are initialized, all
+ * other modules when the MBI is constructed.
+ *
+ * \pre Fw_cfg must have been initialized.
+ */
+class Boot_modules_fw_cfg : public Boot_modules_list
+{
+public:
+  /**
+   * Read the module list.
+   *
+   * \retval true   Modules are provided through fw_cfg.
+   * \retval false  No (valid) module list found.
+   */
+  bool probe();
+
+  void init_mod_regions() override;
+  l4util_l4mod_info *construct_mbi(unsigned long mod_addr,
+                                   Internal_module_list const &mods) override;
+  void move_module(unsigned index, void *dest) override;
+
+private:
+  void load(unsigned index, l4_addr_t addr, Region::Type type);
+
+  bool _probed = false;
+};
@@ -15,6 +15,7 @@
 #include <l4/util/printf_helpers.h>
 #include <l4/sys/consts.h>
 
+#include "log.h"
 #include "region.h"
 #include "module.h"
 
@@ -93,6 +94,7 @@ Region_list::add_nolimitcheck(Region const &region, bool may_overlap)
         {
           if (!may_overlap && !(region < *r))
             {
+              log_unbuffer();
               int ret = printf("  New region for list '%s':", _name);
               region.vprint(true);
               printf("  overlaps with:%*s", ret - 16, "");
@@ -117,45 +119,64 @@ Region_list::add(Region const &region, bool may_overlap)
 
   if (mem.invalid())
     {
-      printf("  WARNING: trying to add invalid region to %s list.\n", _name);
+      log_warn("  WARNING: trying to add invalid region to %s list.\n", _name);
       return;
     }
 
+  bool const warn = log_enabled(Log_warn);
+
   if (mem.begin() > _address_limit)
     {
-      printf("  Dropping '%s' region ", _name);
-      mem.print();
-      printf(" due to %lu MiB address limit\n", _address_limit >> 20);
+      if (warn)
+        {
+          printf("  Dropping '%s' region ", _name);
+          mem.print();
+          printf(" due to %lu MiB address limit\n", _address_limit >> 20);
+        }
       return;
     }
 
   if (mem.end() >= _address_limit)
     {
-      printf("  Limiting '%s' region ", _name);
-      mem.print();
+      if (warn)
+        {
+          printf("  Limiting '%s' region ", _name);
+          mem.print();
+        }
       mem.end(_address_limit - 1);
-      printf(" to ");
-      mem.print();
-      printf(" due to %lu MiB address limit\n", _address_limit >> 20);
-
+      if (warn)
+        {
+          printf(" to ");
+          mem.print();
+          printf(" due to %lu MiB address limit\n", _address_limit >> 20);
+        }
     }
 
   if (_combined_size >= _max_combined_size)
     {
-      printf("  Dropping '%s' region ", _name);
-      mem.print();
-      printf(" due to %lu MiB size limit\n", _max_combined_size >> 20);
+      if (warn)
+        {
+          printf("  Dropping '%s' region ", _name);
+          mem.print();
+          printf(" due to %lu MiB size limit\n", _max_combined_size >> 20);
+        }
       return;
     }
 
   if (_combined_size + mem.size() > _max_combined_size)
     {
-      printf("  Limiting '%s' region ", _name);
-      mem.print();
+      if (warn)
+        {
+          printf("  Limiting '%s' region ", _name);
+          mem.print();
+        }
       mem.end(mem.begin() + _max_combined_size - _combined_size - 1);
-      printf(" to ");
-      mem.print();
-      printf(" due to %lu MiB size limit\n", _max_combined_size >> 20);
+      if (warn)
+        {
+          printf(" to ");
+          mem.print();
+          printf(" due to %lu MiB size limit\n", _max_combined_size >> 20);
+        }
     }
 
   add_nolimitcheck(mem, may_overlap);
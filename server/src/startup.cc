@@ -33,21 +33,29 @@
 #include "panic.h"
 
 /* local stuff */
+#include "boot_log.h"
+#include "boot_timing.h"
+#include "bulk_copy.h"
 #include "exec.h"
 #include "memory.h"
-#include "memcpy_aligned.h"
 #include "module.h"
+#include "mp_workers.h"
 #include "init_kip.h"
 #include "koptions.h"
 #include "platform.h"
 #include "region.h"
 #include "startup.h"
 #include "support.h"
+#include "timestamp.h"
 
 #if defined(__aarch64__) || defined(__arm__)
 #include "arch/arm/mem.h"
 #endif
 
+#if defined(ARCH_arm64)
+#include "ARCH-arm64/mmu.h"
+#endif
+
 #undef getchar
 
 /* management of allocated memory regions */
@@ -107,14 +115,6 @@ struct Elf_info
   l4_addr_t offset;
 };
 
-struct Hdr_info
-{
-  unsigned hdr_type;
-  l4_addr_t start;
-  l4_size_t size;
-  l4_addr_t file_ofs;
-};
-
 struct Section_info
 {
   l4_addr_t start = ~0UL;
@@ -126,9 +126,18 @@ struct Section_info
 
 static exec_handler_func_t l4_exec_read_exec;
 static exec_handler_func_t l4_exec_add_region;
-static exec_handler_func_t l4_exec_find_hdr;
 static exec_handler_func_t l4_exec_gather_info;
 
+/// Parsed program headers of a base module (kernel, sigma0, roottask)
+struct Elf_cache_entry
+{
+  unsigned index;
+  Elf_segments segs;
+};
+
+static Elf_cache_entry elf_cache[1 + 2 * Platform_base::Max_num_nodes];
+static unsigned elf_cache_num;
+
 // this function can be provided per architecture
 void __attribute__((weak)) print_cpu_info();
 
@@ -157,6 +166,48 @@ dump_mbi(l4util_mb_info_t *mbi)
 }
 #endif
 
+/**
+ * Get the parsed program headers of a boot module.
+ *
+ * The ELF headers of each module are parsed only on first use. Later calls
+ * return the cached result even if the module was moved in the meantime.
+ */
+static Elf_segments const &
+elf_segments(Boot_modules *mods, unsigned index)
+{
+  for (unsigned i = 0; i < elf_cache_num; ++i)
+    if (elf_cache[i].index == index)
+      return elf_cache[i].segs;
+
+  if (elf_cache_num >= sizeof(elf_cache) / sizeof(elf_cache[0]))
+    panic("Too many ELF modules");
+
+  Boot_modules::Module m = mods->module(index);
+  Elf_cache_entry *e = &elf_cache[elf_cache_num];
+  const char *error_msg;
+  if (e->segs.init(m, &error_msg))
+    {
+      if (log_enabled(Log_debug))
+        {
+          printf("\n%p: ", m.start);
+          for (int i = 0; i < 4; ++i)
+            printf("%08x ", *(reinterpret_cast<const unsigned *>(m.start) + i));
+          printf("  ");
+          for (int i = 0; i < 16; ++i)
+            {
+              char *c_ptr = const_cast<char *>(m.start + i);
+              unsigned char c = *(reinterpret_cast<unsigned char *>(c_ptr));
+              printf("%c", c < 32 ? '.' : c);
+            }
+        }
+      panic("\nThis is an invalid binary, fix it (%s).", error_msg);
+    }
+
+  e->index = index;
+  ++elf_cache_num;
+  return e->segs;
+}
+
 /**
  * Search for the right KIP.
  *
@@ -187,19 +238,17 @@ l4_kernel_info_t *search_kip(l4_kernel_info_t *kip, l4_size_t size,
  * After loading the kernel we scan for the magic number at page boundaries.
  */
 static
-l4_kernel_info_t *find_kip(Boot_modules::Module const &mod, l4_addr_t offset,
+l4_kernel_info_t *find_kip(Elf_segments const &segs, l4_addr_t offset,
                            unsigned node)
 {
-  const char *error_msg;
-  Hdr_info hdr;
-  hdr.hdr_type = PT_CUSTOM_L4_KIP;
-  if (exec_load_elf(l4_exec_find_hdr, &hdr, mod, &error_msg) != 1)
+  ElfW(Phdr) const *ph = segs.find_hdr(PT_CUSTOM_L4_KIP);
+  if (!ph)
     panic("Could not find kernel info page, maybe your kernel is too old");
 
-  auto *kip = reinterpret_cast<l4_kernel_info_t *>(hdr.start + offset);
-  kip = search_kip(kip, hdr.size, node);
+  auto *kip = reinterpret_cast<l4_kernel_info_t *>(ph->p_paddr + offset);
+  kip = search_kip(kip, ph->p_memsz, node);
   if (kip)
-    printf("  found node %u kernel info page (via ELF) at %p\n", node, kip);
+    log_verbose("  found node %u kernel info page (via ELF) at %p\n", node, kip);
 
   return kip;
 }
@@ -208,20 +257,18 @@ l4_kernel_info_t *find_kip(Boot_modules::Module const &mod, l4_addr_t offset,
  * Check the kernel boot module if a KIP exists for an AMP node.
  */
 static
-bool kip_exists_for_node(Boot_modules::Module const &mod, unsigned node)
+bool kip_exists_for_node(Boot_modules::Module const &mod,
+                         Elf_segments const &segs, unsigned node)
 {
-  const char *error_msg;
-  Hdr_info hdr;
-  hdr.hdr_type = PT_CUSTOM_L4_KIP;
-
   // Find the KIP elf section. If we don't find one, we err on the safe side
   // and assume that a KIP exists.
-  if (exec_load_elf(l4_exec_find_hdr, &hdr, mod, &error_msg) != 1)
+  ElfW(Phdr) const *ph = segs.find_hdr(PT_CUSTOM_L4_KIP);
+  if (!ph)
     return true;
 
   auto *kip = reinterpret_cast<l4_kernel_info_t const *>(mod.start
-                                                         + hdr.file_ofs);
-  return search_kip(const_cast<l4_kernel_info_t *>(kip), hdr.size, node);
+                                                         + ph->p_offset);
+  return search_kip(const_cast<l4_kernel_info_t *>(kip), ph->p_memsz, node);
 }
 
 static
@@ -240,29 +287,25 @@ void copy_kip_feature_string(l4_kernel_info_t *dst, l4_kernel_info_t const *src)
 }
 
 static
-L4_kernel_options::Options *find_kopts(Boot_modules::Module const &mod,
+L4_kernel_options::Options *find_kopts(Elf_segments const &segs,
                                        void *kip, l4_addr_t offset,
                                        unsigned node)
 {
   L4_kernel_options::Options *ko = nullptr;
-  const char *error_msg;
-  Hdr_info hdr;
-  hdr.hdr_type = PT_CUSTOM_L4_KOPT;
-  int r = exec_load_elf(l4_exec_find_hdr, &hdr, mod, &error_msg);
 
-  if (r == 1)
+  if (ElfW(Phdr) const *ph = segs.find_hdr(PT_CUSTOM_L4_KOPT))
     {
-      hdr.start += offset;
-      ko = reinterpret_cast<L4_kernel_options::Options *>(hdr.start);
-      while (hdr.size >= sizeof(*ko))
+      l4_size_t size = ph->p_memsz;
+      ko = reinterpret_cast<L4_kernel_options::Options *>(ph->p_paddr + offset);
+      while (size >= sizeof(*ko))
         {
           if (ko->node == node)
             {
-              printf("  found node %u kernel options (via ELF) at %p\n", node, ko);
+              log_verbose("  found node %u kernel options (via ELF) at %p\n", node, ko);
               break;
             }
           ko++;
-          hdr.size -= sizeof(*ko);
+          size -= sizeof(*ko);
         }
 
       if (!ko)
@@ -270,7 +313,7 @@ L4_kernel_options::Options *find_kopts(Boot_modules::Module const &mod,
     }
   else
     {
-      printf("  assuming kernel options directly following the KIP.\n");
+      log_verbose("  assuming kernel options directly following the KIP.\n");
       auto a = l4_round_page(reinterpret_cast<unsigned long>(kip)
                              + sizeof(l4_kernel_info_t));
       ko = reinterpret_cast<L4_kernel_options::Options *>(a);
@@ -420,8 +463,8 @@ static void verbose_memset(unsigned long begin, unsigned long end,
 {
   assert(begin <= end);
 
-  printf("Presetting memory %16lx - %16lx to '0x%x'\n", begin, end, val);
-  memset((void *)begin, val, end - begin + 1);
+  log_verbose("Presetting memory %16lx - %16lx to '0x%x'\n", begin, end, val);
+  Mp_workers::fill(begin, end - begin + 1, val);
 }
 
 /**
@@ -435,6 +478,8 @@ static void verbose_memset(unsigned long begin, unsigned long end,
  */
 static void fill_mem(l4_uint8_t fill_value)
 {
+  Mp_workers::start();
+
   for (Region const &ram_region : ram)
     {
       // <ram_region_begin, ram_region_end> is the working range.
@@ -480,6 +525,9 @@ static void fill_mem(l4_uint8_t fill_value)
       if (ram_region_begin <= ram_region_end)
         verbose_memset(ram_region_begin, ram_region_end, fill_value);
     }
+
+  Mp_workers::report("Presetting memory");
+  Mp_workers::stop();
 }
 
 static Region bootstrap_region()
@@ -516,22 +564,20 @@ finalize_regions()
  * Actually does not load the ELF binary (see load_elf_module()).
  */
 static void
-add_elf_regions(Boot_modules::Module const &m, Region::Type type,
+add_elf_regions(Boot_modules *mods, unsigned index, Region::Type type,
                 l4_addr_t *offset, unsigned node, l4_addr_t min_align = 0)
 {
   Section_info si;
   Elf_info info;
-  int r;
-  const char *error_msg;
+  Boot_modules::Module m = mods->module(index);
+  Elf_segments const &segs = elf_segments(mods, index);
 
   si.needs_relocation = !m.attrs.find("reloc").empty();
   info.type = type;
 
-  printf("  Scanning %s\n", m.cmdline);
+  log_verbose("  Scanning %s\n", m.cmdline);
 
-  r = exec_load_elf(l4_exec_gather_info, &si, m, &error_msg);
-  if (r)
-    panic("Could not gather load section infos (%s)", error_msg);
+  segs.for_each(l4_exec_gather_info, &si, m);
 
   // Just do relocation if it's required. Otherwise it might break working
   // setups by provoking collisions with other (non-relocatable) binaries.
@@ -582,25 +628,7 @@ add_elf_regions(Boot_modules::Module const &m, Region::Type type,
     Platform_base::platform
       ->firmware_announce_memory(Region(si.start + *offset, si.end + *offset));
 
-  r = exec_load_elf(l4_exec_add_region, &info, m, &error_msg);
-
-  if (r)
-    {
-      if (Verbose_load)
-        {
-          printf("\n%p: ", m.start);
-          for (int i = 0; i < 4; ++i)
-            printf("%08x ", *(reinterpret_cast<const unsigned *>(m.start) + i));
-          printf("  ");
-          for (int i = 0; i < 16; ++i)
-            {
-              char *c_ptr = const_cast<char *>(m.start + i);
-              unsigned char c = *(reinterpret_cast<unsigned char *>(c_ptr));
-              printf("%c", c < 32 ? '.' : c);
-            }
-        }
-      panic("\nThis is an invalid binary, fix it (%s).", error_msg);
-    }
+  segs.for_each(l4_exec_add_region, &info, m);
 }
 
 
@@ -609,14 +637,10 @@ add_elf_regions(Boot_modules::Module const &m, Region::Type type,
  * memory region.
  */
 static l4_addr_t
-load_elf_module(Boot_modules::Module const &mod, l4_addr_t offset)
+load_elf_module(Boot_modules::Module const &mod, Elf_segments const &segs,
+                l4_addr_t offset)
 {
-  const char *error_msg;
-
-  int r = exec_load_elf(l4_exec_read_exec, reinterpret_cast<void*>(offset), mod,
-                    &error_msg);
-  if (r)
-    panic("Can't load module (%s)", error_msg);
+  segs.for_each(l4_exec_read_exec, reinterpret_cast<void*>(offset), mod);
 
   Region m = Region::start_size(mod.start, l4_round_page(mod.end) - mod.start);
   if (!regions.sub(m))
@@ -625,7 +649,7 @@ load_elf_module(Boot_modules::Module const &mod, l4_addr_t offset)
       regions.sub(m);
     }
 
-  return reinterpret_cast<ElfW(Ehdr) const *>(mod.start)->e_entry + offset;
+  return segs.entry() + offset;
 }
 
 #ifdef ARCH_mips
@@ -669,7 +693,7 @@ search_and_setup_utest_feature(char const *cmdline, l4_kernel_info_t *info)
         size_t cpy_len = opts_len < max_len ? opts_len : max_len;
 
         if (opts_len > max_len)
-          printf("Warning: %s argument too long for feature placeholder. Truncated to fit.\n", arg);
+          log_warn("Warning: %s argument too long for feature placeholder. Truncated to fit.\n", arg);
 
         // We explicitly want to replace the placeholder string in this
         // feature, thus the const_cast. Don't copy the null terminator.
@@ -678,8 +702,10 @@ search_and_setup_utest_feature(char const *cmdline, l4_kernel_info_t *info)
 }
 
 static unsigned long
-load_elf_module(Boot_modules::Module const &mod, char const *n, l4_addr_t offset)
+load_elf_module(Boot_modules *mods, unsigned index, char const *n,
+                l4_addr_t offset)
 {
+  Boot_modules::Module mod = mods->module(index);
   printf("  Loading ");
   print_module_name(mod.cmdline, n);
   if (offset)
@@ -688,7 +714,10 @@ load_elf_module(Boot_modules::Module const &mod, char const *n, l4_addr_t offset
       printf(" (offset %c0x%lx)", neg?'-':'+', neg ? (~offset + 1U) : offset);
     }
   putchar('\n');
-  return load_elf_module(mod, offset);
+  l4_uint64_t start = timestamp();
+  unsigned long entry = load_elf_module(mod, elf_segments(mods, index), offset);
+  Boot_timing::module(Boot_timing::Load, mod.cmdline, start, mod.size());
+  return entry;
 }
 
 /**
@@ -698,15 +727,27 @@ load_elf_module(Boot_modules::Module const &mod, char const *n, l4_addr_t offset
 void
 startup(char const *cmdline)
 {
+  Boot_timing::phase("firmware");
+
   if (!cmdline || !*cmdline)
     cmdline = builtin_cmdline;
 
+  bulk_copy_init();
+
   if (check_arg(cmdline, "-noserial"))
     {
       set_stdio_uart(NULL);
       kuart_flags |= L4_kernel_options::F_noserial;
     }
 
+  if (char const *s = check_arg(cmdline, "-loglevel="))
+    log_level = strtoul(s, NULL, 0);
+
+  if (check_arg(cmdline, "-quiet"))
+    Boot_log::enable(true);
+  else if (check_arg(cmdline, "-bootlog"))
+    Boot_log::enable(false);
+
   if (!Platform_base::platform)
     {
       // will we ever see this?
@@ -757,14 +798,23 @@ startup(char const *cmdline)
 
   setup_memory_map(cmdline);
 
+#if defined(ARCH_arm64)
+  // Moving, decompressing and loading modules is a lot faster with caches.
+  // Enable them before the modules are probed, some module sources already
+  // read and decompress the modules then.
+  if (!check_arg(cmdline, "-nommu"))
+    mmu_enable_identity(ram, regions, bootstrap_region());
+#endif
+
   /* basically add the bootstrap binary to the allocated regions */
   init_regions();
   plat->init_regions();
+  Boot_timing::phase("memory map");
 
   if (const char *s = check_arg(cmdline, "-modaddr"))
     {
       if (*(s++) != '=')
-        printf("Separating 'modaddr' arguments by other characters than '='\n"
+        log_warn("Separating 'modaddr' arguments by other characters than '='\n"
                "is deprecated and will be removed in the future. Please\n"
                "adapt your configuration.\n");
       l4_addr_t addr = strtoul(s, 0, 0);
@@ -784,6 +834,8 @@ startup(char const *cmdline)
       presetmem = true;
     }
 
+  bool bootstats = check_arg(cmdline, "-bootstats");
+
   Boot_modules *mods = plat->modules();
 
   int idx_kern = mods->base_mod_idx(L4util_l4mod_mod_flag_kernel);
@@ -801,7 +853,7 @@ startup(char const *cmdline)
 
   // The kernel must be loaded super-page aligned, even if the ELF file PHDRs
   // do not require it!
-  add_elf_regions(mods->module(idx_kern), Region::Kernel, &fiasco_offset,
+  add_elf_regions(mods, idx_kern, Region::Kernel, &fiasco_offset,
                   first_node, L4_SUPERPAGESIZE);
 
   // No EFI services after this point. Do after add_elf_regions(Kernel) because
@@ -811,36 +863,52 @@ startup(char const *cmdline)
   for (unsigned i = 0; i < num_nodes; i++)
     {
       unsigned n = first_node + i;
-      if (!kip_exists_for_node(mods->module(idx_kern), n))
+      if (!kip_exists_for_node(mods->module(idx_kern),
+                               elf_segments(mods, idx_kern), n))
         continue;
 
       int idx_sigma0 = mods->base_mod_idx(L4util_l4mod_mod_flag_sigma0, n);
       if (idx_sigma0 >= 0)
-        add_elf_regions(mods->module(idx_sigma0), Region::Sigma0,
+        add_elf_regions(mods, idx_sigma0, Region::Sigma0,
                         &sigma0_offset[i], n);
 
       int idx_roottask = mods->base_mod_idx(L4util_l4mod_mod_flag_roottask, n);
       if (idx_roottask >= 0)
-        add_elf_regions(mods->module(idx_roottask), Region::Root,
+        add_elf_regions(mods, idx_roottask, Region::Root,
                         &roottask_offset[i], n);
     }
 
+  Boot_timing::phase("elf regions");
+  plat->map_upper_ram();
+  Boot_timing::add_module(internal_mods);
+  Boot_log::add_module(internal_mods);
+  if (check_arg(cmdline, "-dtcompact"))
+    plat->compact_dt();
+  plat->add_platform_summary(internal_mods);
+
+  // Module moves and checksums as well as loading the ELF segments are done
+  // on all CPUs the platform can bring up
+  unsigned num_workers = Mp_workers::start();
+  log_info("  Moving, checking and loading modules on %u CPU%s.\n",
+           num_workers + 1, num_workers ? "s" : "");
+
   l4util_l4mod_info *mbi = plat->modules()->construct_mbi(_mod_addr, internal_mods);
   cmdline = nullptr;
 
   assert(mbi->mods_count <= MODS_MAX);
   assert(plat->current_node() == first_node);
+  Boot_timing::phase("modules");
 
   boot_info_t boot_info;
   regions.optimize();
 
   /* setup kernel PART ONE */
-  boot_info.kernel_start = load_elf_module(mods->module(idx_kern), "[KERNEL]",
+  boot_info.kernel_start = load_elf_module(mods, idx_kern, "[KERNEL]",
                                            fiasco_offset);
 
   char const *kernel_cmdline = mods->module(idx_kern).cmdline;
-  l4_kernel_info_t *kip = find_kip(mods->module(idx_kern), fiasco_offset,
-                                   first_node);
+  Elf_segments const &kern_segs = elf_segments(mods, idx_kern);
+  l4_kernel_info_t *kip = find_kip(kern_segs, fiasco_offset, first_node);
   if (!kip)
     panic("No KIP found!");
 
@@ -848,7 +916,7 @@ startup(char const *cmdline)
   for (unsigned i = 0; i < num_nodes; i++)
     {
       unsigned n = first_node + i;
-      l4_kernel_info_t *l4i = i == 0 ? kip : find_kip(mods->module(idx_kern),
+      l4_kernel_info_t *l4i = i == 0 ? kip : find_kip(kern_segs,
                                                       fiasco_offset, n);
       if (!l4i)
         continue;
@@ -864,24 +932,24 @@ startup(char const *cmdline)
       /* setup sigma0 */
       int idx_sigma0 = mods->base_mod_idx(L4util_l4mod_mod_flag_sigma0, n);
       if (idx_sigma0 >= 0)
-        boot_info.sigma0_start = load_elf_module(mods->module(idx_sigma0),
+        boot_info.sigma0_start = load_elf_module(mods, idx_sigma0,
                                                  "[SIGMA0]",
                                                  sigma0_offset[i]);
       else
-        printf("  WARNING: No sigma0 module for node %d -- setup might not boot!\n", n);
+        log_warn("  WARNING: No sigma0 module for node %d -- setup might not boot!\n", n);
 
       /* setup roottask */
       int idx_roottask = mods->base_mod_idx(L4util_l4mod_mod_flag_roottask, n);
       if (idx_roottask >= 0)
-        boot_info.roottask_start = load_elf_module(mods->module(idx_roottask),
+        boot_info.roottask_start = load_elf_module(mods, idx_roottask,
                                                    "[ROOTTASK]",
                                                    roottask_offset[i]);
       else
-        printf("  WARNING: No roottask module for node %d -- setup might not boot!\n", n);
+        log_warn("  WARNING: No roottask module for node %d -- setup might not boot!\n", n);
 
       plat->late_setup(l4i);
 
-      L4_kernel_options::Options *lko = find_kopts(mods->module(idx_kern), l4i,
+      L4_kernel_options::Options *lko = find_kopts(kern_segs, l4i,
                                                    fiasco_offset, n);
 
       kcmdline_parse(kernel_cmdline, lko);
@@ -894,28 +962,42 @@ startup(char const *cmdline)
       plat->setup_kernel_options(lko);
     }
 
+  Mp_workers::report("Moving, checking and loading modules");
+  Mp_workers::stop();
+  Boot_timing::phase("elf load");
+
   // Note: we have to ensure that the original ELF binaries are not modified
   // or overwritten up to this point. However, the memory regions for the
   // original ELF binaries are freed during load_elf_module() but might be
   // used up to here.
   // ------------------------------------------------------------------------
 
+#if defined(ARCH_arm64)
+  // The kernel expects MMU and caches disabled. Also the workers filling the
+  // memory run uncached.
+  mmu_disable_identity();
+#endif
+
   // The ELF binaries for the kernel, sigma0, and roottask must no
   // longer be used from here on.
   if (presetmem)
-    fill_mem(presetmem_value);
+    {
+      fill_mem(presetmem_value);
+      Boot_timing::phase("presetmem");
+    }
 
   plat->finalize_regions();
   finalize_regions();
   regions.optimize();
-  regions.dump();
+  if (log_enabled(Log_verbose))
+    regions.dump();
 
   /* setup kernel PART THREE: memory descriptors to all KIPs after
    * finalizing regions */
   for (unsigned i = 0; i < num_nodes; i++)
     {
       unsigned n = first_node + i;
-      l4_kernel_info_t *l4i = i == 0 ? kip : find_kip(mods->module(idx_kern),
+      l4_kernel_info_t *l4i = i == 0 ? kip : find_kip(kern_segs,
                                                       fiasco_offset, n);
       if (!l4i)
         continue;
@@ -923,6 +1005,12 @@ startup(char const *cmdline)
       init_kip_md(l4i, &ram, &regions);
     }
 
+  Boot_timing::phase("kip");
+  Boot_timing::print();
+  if (bootstats)
+    Boot_timing::print_stats();
+  Boot_timing::finish();
+
   printf("  Starting kernel ");
   print_module_name(kernel_cmdline, "[KERNEL]");
   printf(" at " l4_addr_fmt "\n", boot_info.kernel_start);
@@ -944,6 +1032,7 @@ startup(char const *cmdline)
   }
 #endif
 
+  Boot_log::finish();
   plat->boot_kernel(boot_info.kernel_start);
   /*NORETURN*/
 }
@@ -961,13 +1050,12 @@ l4_exec_read_exec(void *opaque, ElfW(Phdr) const *ph,
 
   auto mem_addr = ph->p_paddr + offset;
 
-  if (Verbose_load)
-    printf("    [%p-%p]\n", (void *)mem_addr, (void *)(mem_addr + ph->p_memsz));
+  log_debug("    [%p-%p]\n", (void *)mem_addr, (void *)(mem_addr + ph->p_memsz));
 
   if (!ram.contains(Region::start_size(mem_addr, ph->p_memsz)))
     {
-      printf("To be loaded binary region is out of memory region.\n");
-      printf(" Binary region: %lx - %lx\n", l4_addr_t{mem_addr},
+      log_error("To be loaded binary region is out of memory region.\n");
+      log_error(" Binary region: %lx - %lx\n", l4_addr_t{mem_addr},
              l4_addr_t{mem_addr + ph->p_memsz});
       dump_ram_map();
       panic("Binary outside memory");
@@ -975,11 +1063,14 @@ l4_exec_read_exec(void *opaque, ElfW(Phdr) const *ph,
 
   auto *src = m.start + ph->p_offset;
   auto *dst = reinterpret_cast<char *>(mem_addr);
-  if (reinterpret_cast<unsigned long>(src) % 8
-      || reinterpret_cast<unsigned long>(dst) % 8)
-    memcpy(dst, src, ph->p_filesz);
+  l4_uint64_t ts = timestamp();
+  if (dst + ph->p_filesz <= src || src + ph->p_filesz <= dst)
+    Mp_workers::copy(reinterpret_cast<l4_addr_t>(dst),
+                     reinterpret_cast<l4_addr_t>(src), ph->p_filesz);
   else
-    memcpy_aligned(dst, src, ph->p_filesz);
+    bulk_move(dst, src, ph->p_filesz);
+  Boot_timing::account(Boot_timing::Copy, m.cmdline, timestamp() - ts,
+                       ph->p_filesz);
 
 #if defined(__aarch64__) || defined(__arm__)
   if (ph->p_flags & PF_X)
@@ -991,12 +1082,18 @@ l4_exec_read_exec(void *opaque, ElfW(Phdr) const *ph,
 #endif
 
   if (ph->p_filesz < ph->p_memsz)
-    memset(dst + ph->p_filesz, 0, ph->p_memsz - ph->p_filesz);
+    {
+      ts = timestamp();
+      Mp_workers::fill(reinterpret_cast<l4_addr_t>(dst + ph->p_filesz),
+                       ph->p_memsz - ph->p_filesz, 0);
+      Boot_timing::account(Boot_timing::Zero, m.cmdline, timestamp() - ts,
+                           ph->p_memsz - ph->p_filesz);
+    }
 
   Region *f = regions.find(mem_addr);
   if (!f)
     {
-      printf("could not find %lx\n", l4_addr_t{mem_addr});
+      log_error("could not find %lx\n", l4_addr_t{mem_addr});
       regions.dump();
       panic("Region for module not found");
     }
@@ -1046,7 +1143,7 @@ l4_exec_add_region(void *opaque, ElfW(Phdr) const *ph,
 
   if (Region const *r = find_region_overlap(n))
     {
-      printf("  New region:   ");
+      log_error("  New region:   ");
       n.vprint(true);
       printf("  overlaps with:");
       r->vprint(true);
@@ -1058,21 +1155,6 @@ l4_exec_add_region(void *opaque, ElfW(Phdr) const *ph,
   return 0;
 }
 
-static int
-l4_exec_find_hdr(void *opaque, ElfW(Phdr) const *ph,
-                 Boot_modules::Module const &)
-{
-  Hdr_info *hdr = static_cast<Hdr_info *>(opaque);
-  if (hdr->hdr_type == ph->p_type)
-    {
-      hdr->start = ph->p_paddr;
-      hdr->size = ph->p_memsz;
-      hdr->file_ofs = ph->p_offset;
-      return 1;
-    }
-  return 0;
-}
-
 static int
 l4_exec_gather_info(void *opaque, ElfW(Phdr) const *ph,
                     Boot_modules::Module const &)
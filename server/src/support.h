@@ -16,6 +16,7 @@
 #include <l4/drivers/uart_base.h>
 #include <l4/util/l4mod.h>
 #include <l4/sys/compiler.h>
+#include "log.h"
 #include "mod_info.h"
 #include "region.h"
 
@@ -32,11 +33,12 @@ extern struct boot_args boot_args;
 
 L4::Uart *uart();
 void set_stdio_uart(L4::Uart *uart);
+void console_write(char const *s, unsigned long len);
 void ctor_init();
 
-enum { Verbose_load = 0 };
-
 void init_modules_infos();
+class Mod_header;
+void use_modules_infos(Mod_header *hdr);
 
 template<typename T>
 inline T *l4_round_page(T *p)
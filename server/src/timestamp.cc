@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include "timestamp.h"
+
+static l4_uint64_t freq;
+
+#if defined(ARCH_x86) || defined(ARCH_amd64)
+static void cpuid(l4_uint32_t leaf, l4_uint32_t *a, l4_uint32_t *b,
+                  l4_uint32_t *c)
+{
+  l4_uint32_t d;
+  asm volatile ("cpuid" : "=a" (*a), "=b" (*b), "=c" (*c), "=d" (d)
+                        : "a" (leaf), "c" (0));
+}
+
+/**
+ * Determine the TSC frequency from CPUID.
+ *
+ * Leaf 0x15 provides the exact ratio to the crystal clock, leaf 0x16 only
+ * the nominal base frequency.
+ */
+static l4_uint64_t tsc_freq()
+{
+  l4_uint32_t max, a, b, c;
+  cpuid(0, &max, &b, &c);
+
+  if (max >= 0x15)
+    {
+      cpuid(0x15, &a, &b, &c);
+      if (a && b && c)
+        return l4_uint64_t{c} * b / a;
+    }
+
+  if (max >= 0x16)
+    {
+      cpuid(0x16, &a, &b, &c);
+      return l4_uint64_t{a & 0xffff} * 1000000;
+    }
+
+  return 0;
+}
+#endif
+
+#if defined(ARCH_mips)
+l4_uint64_t timestamp_mips()
+{
+  // CP0 Count is only 32 bits wide. Extend it assuming that it is read at
+  // least once per wrap-around.
+  static l4_uint32_t last;
+  static l4_uint64_t high;
+
+  l4_uint32_t c;
+  asm volatile ("mfc0 %0, $9" : "=r" (c));
+  if (c < last)
+    high += 1ULL << 32;
+  last = c;
+  return high | c;
+}
+#endif
+
+l4_uint64_t timestamp_freq()
+{
+#if defined(ARCH_arm64)
+  if (!freq)
+    asm ("mrs %0, CNTFRQ_EL0" : "=r" (freq));
+#elif defined(ARCH_x86) || defined(ARCH_amd64)
+  if (!freq)
+    freq = tsc_freq();
+#endif
+  return freq;
+}
+
+void timestamp_set_freq(l4_uint64_t hz)
+{
+  freq = hz;
+}
+
+l4_uint64_t timestamp_to_us(l4_uint64_t ticks)
+{
+  l4_uint64_t hz = timestamp_freq();
+  if (!hz)
+    return 0;
+
+  // Avoid overflowing ticks * 1000000 for long intervals
+  return ticks / hz * 1000000 + ticks % hz * 1000000 / hz;
+}
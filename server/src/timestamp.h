@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include <l4/sys/l4int.h>
+
+#if defined(ARCH_mips)
+l4_uint64_t timestamp_mips();
+#endif
+
+/**
+ * Read the free-running counter of the current CPU.
+ *
+ * \return Counter value, 0 if the architecture has no usable counter.
+ */
+static inline l4_uint64_t timestamp()
+{
+#if defined(ARCH_arm64)
+  l4_uint64_t v;
+  asm volatile ("isb; mrs %0, CNTVCT_EL0" : "=r" (v));
+  return v;
+#elif defined(ARCH_riscv) && __riscv_xlen == 64
+  l4_uint64_t v;
+  asm volatile ("rdtime %0" : "=r" (v));
+  return v;
+#elif defined(ARCH_riscv)
+  l4_uint32_t hi, lo, tmp;
+  asm volatile ("1: rdtimeh %0\n"
+                "   rdtime  %1\n"
+                "   rdtimeh %2\n"
+                "   bne %0, %2, 1b"
+                : "=&r" (hi), "=&r" (lo), "=&r" (tmp));
+  return (l4_uint64_t{hi} << 32) | lo;
+#elif defined(ARCH_x86) || defined(ARCH_amd64)
+  l4_uint32_t hi, lo;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return (l4_uint64_t{hi} << 32) | lo;
+#elif defined(ARCH_mips)
+  return timestamp_mips();
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Frequency of the counter read by timestamp().
+ *
+ * \return Frequency in Hz, 0 if unknown.
+ */
+l4_uint64_t timestamp_freq();
+
+/**
+ * Set the counter frequency for architectures which cannot query it.
+ *
+ * \param hz  Frequency in Hz.
+ */
+void timestamp_set_freq(l4_uint64_t hz);
+
+/**
+ * Convert a counter difference to microseconds.
+ *
+ * \return Microseconds, 0 if the counter frequency is unknown.
+ */
+l4_uint64_t timestamp_to_us(l4_uint64_t ticks);
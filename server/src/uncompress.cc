@@ -33,7 +33,7 @@ void free(void * /*address*/)
 void* malloc(size_t size)
 {
   unsigned long remaining = &static_buf[sizeof(static_buf)] - free_ptr;
-  size = (size + sizeof(long) - 1U) & (sizeof(long) - 1U);
+  size = (size + sizeof(long) - 1U) & ~(sizeof(long) - 1U);
   if (size > remaining)
     {
       printf("Cannot alloc %lu bytes, only %lu available\n", size, remaining);
@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <stdio.h>
+
+#include <l4/cxx/minmax>
+#include <l4/cxx/utils>
+#include <l4/drivers/asm_access.h>
+#include <l4/sys/consts.h>
+
+#include "io_barrier.h"
+#include "panic.h"
+#include "support.h"
+#include "timestamp.h"
+#include "virtio_blk.h"
+
+namespace
+{
+
+enum
+{
+  Mmio_magic          = 0x000,
+  Mmio_version        = 0x004,
+  Mmio_device_id      = 0x008,
+  Mmio_dev_features   = 0x010,
+  Mmio_dev_feat_sel   = 0x014,
+  Mmio_drv_features   = 0x020,
+  Mmio_drv_feat_sel   = 0x024,
+  Mmio_guest_page_sz  = 0x028, // legacy only
+  Mmio_queue_sel      = 0x030,
+  Mmio_queue_num_max  = 0x034,
+  Mmio_queue_num      = 0x038,
+  Mmio_queue_align    = 0x03c, // legacy only
+  Mmio_queue_pfn      = 0x040, // legacy only
+  Mmio_queue_ready    = 0x044,
+  Mmio_queue_notify   = 0x050,
+  Mmio_status         = 0x070,
+  Mmio_queue_desc_lo  = 0x080,
+  Mmio_queue_desc_hi  = 0x084,
+  Mmio_queue_avail_lo = 0x090,
+  Mmio_queue_avail_hi = 0x094,
+  Mmio_queue_used_lo  = 0x0a0,
+  Mmio_queue_used_hi  = 0x0a4,
+  Mmio_config         = 0x100,
+
+  Mmio_magic_value    = 0x74726976, // "virt"
+  Device_id_blk       = 2,
+
+  Status_acknowledge  = 1,
+  Status_driver       = 2,
+  Status_driver_ok    = 4,
+  Status_features_ok  = 8,
+
+  Feature_version_1   = 1, // bit 32, i.e. bit 0 of the second feature word
+
+  Desc_next           = 1,
+  Desc_write          = 2,
+
+  Blk_t_in            = 0,
+  Blk_s_ok            = 0,
+};
+
+enum { Vring_entries = 32 };
+
+struct Vring_desc
+{
+  l4_uint64_t addr;
+  l4_uint32_t len;
+  l4_uint16_t flags;
+  l4_uint16_t next;
+};
+
+struct Vring_used_elem
+{
+  l4_uint32_t id;
+  l4_uint32_t len;
+};
+
+/// Virtqueue in the legacy layout, which also satisfies the modern layout.
+struct Vring
+{
+  Vring_desc desc[Vring_entries];
+
+  struct
+  {
+    l4_uint16_t flags;
+    l4_uint16_t idx;
+    l4_uint16_t ring[Vring_entries];
+  } avail;
+
+  struct alignas(L4_PAGESIZE)
+  {
+    l4_uint16_t flags;
+    l4_uint16_t idx;
+    Vring_used_elem ring[Vring_entries];
+  } used;
+};
+
+struct Blk_req_hdr
+{
+  l4_uint32_t type;
+  l4_uint32_t reserved;
+  l4_uint64_t sector;
+};
+
+// There is only one device in use at a time
+Vring vring __attribute__((aligned(L4_PAGESIZE)));
+Blk_req_hdr req_hdr[Vring_entries / 3];
+l4_uint8_t req_status[Vring_entries / 3];
+
+template<typename T>
+l4_uint64_t
+dma_addr(T const *p)
+{ return reinterpret_cast<l4_addr_t>(p); }
+
+}
+
+l4_uint32_t
+Virtio_blk::reg(unsigned offs) const
+{
+  return Asm_access::read(reinterpret_cast<l4_uint32_t const *>(_base + offs));
+}
+
+void
+Virtio_blk::reg(unsigned offs, l4_uint32_t val) const
+{
+  Asm_access::write(val, reinterpret_cast<l4_uint32_t *>(_base + offs));
+}
+
+bool
+Virtio_blk::init_mmio(l4_addr_t base)
+{
+  static_assert(int{Queue_size} == int{Vring_entries},
+                "Inconsistent queue size");
+
+  _base = base;
+  if (reg(Mmio_magic) != Mmio_magic_value
+      || reg(Mmio_device_id) != Device_id_blk)
+    return false;
+
+  l4_uint32_t version = reg(Mmio_version);
+  if (version != 1 && version != 2)
+    return false;
+
+  reg(Mmio_status, 0);
+  reg(Mmio_status, Status_acknowledge);
+  reg(Mmio_status, Status_acknowledge | Status_driver);
+
+  // We do not need any device features
+  l4_uint32_t status = Status_acknowledge | Status_driver;
+  if (version == 2)
+    {
+      reg(Mmio_dev_feat_sel, 1);
+      if (!(reg(Mmio_dev_features) & Feature_version_1))
+        return false;
+
+      reg(Mmio_drv_feat_sel, 1);
+      reg(Mmio_drv_features, Feature_version_1);
+      reg(Mmio_drv_feat_sel, 0);
+      reg(Mmio_drv_features, 0);
+
+      status |= Status_features_ok;
+      reg(Mmio_status, status);
+      if (!(reg(Mmio_status) & Status_features_ok))
+        return false;
+    }
+  else
+    {
+      reg(Mmio_drv_features, 0);
+      reg(Mmio_guest_page_sz, L4_PAGESIZE);
+    }
+
+  reg(Mmio_queue_sel, 0);
+  if (reg(Mmio_queue_num_max) < Queue_size)
+    {
+      log_warn("virtio-blk: Queue at %lx too small.\n", base);
+      return false;
+    }
+
+  memset(&vring, 0, sizeof(vring));
+  reg(Mmio_queue_num, Queue_size);
+
+  if (version == 2)
+    {
+      reg(Mmio_queue_desc_lo, dma_addr(vring.desc));
+      reg(Mmio_queue_desc_hi, dma_addr(vring.desc) >> 32);
+      reg(Mmio_queue_avail_lo, dma_addr(&vring.avail));
+      reg(Mmio_queue_avail_hi, dma_addr(&vring.avail) >> 32);
+      reg(Mmio_queue_used_lo, dma_addr(&vring.used));
+      reg(Mmio_queue_used_hi, dma_addr(&vring.used) >> 32);
+      reg(Mmio_queue_ready, 1);
+    }
+  else
+    {
+      reg(Mmio_queue_align, L4_PAGESIZE);
+      reg(Mmio_queue_pfn, dma_addr(&vring) >> L4_PAGESHIFT);
+    }
+
+  reg(Mmio_status, status | Status_driver_ok);
+
+  _capacity = reg(Mmio_config)
+              | static_cast<l4_uint64_t>(reg(Mmio_config + 4)) << 32;
+  _avail_idx = 0;
+  _used_idx = 0;
+  _busy = 0;
+
+  return true;
+}
+
+/**
+ * Queue a read request using the descriptors of `slot`.
+ */
+void
+Virtio_blk::submit(unsigned slot, l4_uint64_t sector, l4_addr_t buf,
+                   l4_uint32_t size)
+{
+  unsigned d = slot * 3;
+
+  req_hdr[slot].type = Blk_t_in;
+  req_hdr[slot].reserved = 0;
+  req_hdr[slot].sector = sector;
+  req_status[slot] = 0xff;
+
+  vring.desc[d]     = { dma_addr(&req_hdr[slot]), sizeof(Blk_req_hdr),
+                        Desc_next, static_cast<l4_uint16_t>(d + 1) };
+  vring.desc[d + 1] = { buf, size, Desc_next | Desc_write,
+                        static_cast<l4_uint16_t>(d + 2) };
+  vring.desc[d + 2] = { dma_addr(&req_status[slot]), 1, Desc_write, 0 };
+
+  vring.avail.ring[_avail_idx % Queue_size] = d;
+
+  // The descriptors must be visible before the index update, the index
+  // update before the notification.
+  io_mb();
+  cxx::write_now(&vring.avail.idx, ++_avail_idx);
+  io_mb();
+  reg(Mmio_queue_notify, 0);
+}
+
+void
+Virtio_blk::reset()
+{
+  reg(Mmio_status, 0);
+}
+
+/**
+ * Queue the next request of the read in progress using the descriptors of
+ * `slot`.
+ */
+void
+Virtio_blk::next_req(unsigned slot)
+{
+  l4_uint32_t sz = cxx::min<unsigned long>(_size - _submitted, Req_size);
+  submit(slot, _sector + _submitted / Sector_size, _dest + _submitted, sz);
+  _req_offs[slot] = _submitted;
+  _busy |= 1U << slot;
+  _submitted += sz;
+}
+
+void
+Virtio_blk::start_read(l4_uint64_t sector, void *buf, unsigned long size)
+{
+  if (size % Sector_size)
+    panic("virtio-blk: Unaligned read size %lx.", size);
+
+  if (_busy)
+    panic("virtio-blk: Read already in progress.");
+
+  _sector = sector;
+  _dest = reinterpret_cast<l4_addr_t>(buf);
+  _size = size;
+  _submitted = 0;
+
+  for (unsigned slot = 0; slot < Max_reqs && _submitted < _size; ++slot)
+    next_req(slot);
+}
+
+unsigned long
+Virtio_blk::completed() const
+{
+  unsigned long done = _submitted;
+  for (unsigned slot = 0; slot < Max_reqs; ++slot)
+    if (_busy & (1U << slot) && _req_offs[slot] < done)
+      done = _req_offs[slot];
+
+  return done;
+}
+
+void
+Virtio_blk::wait(unsigned long bytes)
+{
+  if (bytes > _size)
+    bytes = _size;
+
+  l4_uint64_t freq = timestamp_freq();
+  l4_uint64_t t = timestamp();
+  unsigned long loops = 0;
+  while (completed() < bytes)
+    {
+      if (cxx::access_once(&vring.used.idx) == _used_idx)
+        {
+          if (freq ? timestamp_to_us(timestamp() - t) > Io_timeout_us
+                   : ++loops > Io_timeout_loops)
+            panic("virtio-blk: Timeout reading sector %llu.",
+                  _sector + completed() / Sector_size);
+          continue;
+        }
+
+      t = timestamp();
+      loops = 0;
+      io_mb();
+      Vring_used_elem const &e = vring.used.ring[_used_idx % Queue_size];
+      ++_used_idx;
+
+      unsigned slot = e.id / 3;
+      _busy &= ~(1U << slot);
+      if (req_status[slot] != Blk_s_ok)
+        panic("virtio-blk: Read failed: %u.", req_status[slot]);
+
+      if (_submitted < _size)
+        next_req(slot);
+    }
+}
+
+void
+Virtio_blk::read(l4_uint64_t sector, void *buf, unsigned long size)
+{
+  start_read(sector, buf, size);
+  wait(size);
+}
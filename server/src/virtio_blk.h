@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include <l4/sys/l4int.h>
+
+/**
+ * Minimal polling driver for a virtio block device on the virtio-mmio
+ * transport.
+ *
+ * Only reading is supported. The driver does not use interrupts, requests are
+ * completed by polling the used ring. Both the legacy (version 1) and the
+ * modern (version 2) register layout are supported.
+ */
+class Virtio_blk
+{
+public:
+  enum { Sector_size = 512 };
+
+  /**
+   * Initialize the device at `base`.
+   *
+   * \retval true   A virtio block device was found and initialized.
+   * \retval false  There is no virtio block device at `base`.
+   */
+  bool init_mmio(l4_addr_t base);
+
+  /// Capacity of the disk in sectors.
+  l4_uint64_t capacity() const { return _capacity; }
+
+  /**
+   * Read from the disk.
+   *
+   * Up to Max_reqs requests of Req_size bytes are kept in flight to overlap
+   * the request handling of the host with the data transfer.
+   *
+   * \param sector  First sector to read.
+   * \param buf     Destination buffer.
+   * \param size    Number of bytes to read.
+   */
+  void read(l4_uint64_t sector, void *buf, unsigned long size);
+
+  /**
+   * Start reading from the disk without waiting for the data.
+   *
+   * The requests in flight proceed while the caller works on the data read
+   * so far. Only one read can be in progress, it is completed by wait().
+   *
+   * \param sector  First sector to read.
+   * \param buf     Destination buffer.
+   * \param size    Number of bytes to read.
+   */
+  void start_read(l4_uint64_t sector, void *buf, unsigned long size);
+
+  /**
+   * Wait until the first `bytes` of the read in progress are available.
+   *
+   * Completed requests are replaced by the next requests of the read. Panics
+   * if the device does not complete any request for Io_timeout_us.
+   */
+  void wait(unsigned long bytes);
+
+  /**
+   * Reset the device.
+   *
+   * The device stops using the virtqueue, which lives in bootstrap memory.
+   */
+  void reset();
+
+private:
+  enum
+  {
+    Queue_size = 32,
+    Max_reqs   = Queue_size / 3,
+    Req_size   = 512 << 10,
+
+    /// Without a known counter frequency, the number of polls is limited
+    Io_timeout_us    = 10000000,
+    Io_timeout_loops = 2000000000,
+  };
+
+  l4_uint32_t reg(unsigned offs) const;
+  void reg(unsigned offs, l4_uint32_t val) const;
+  void submit(unsigned slot, l4_uint64_t sector, l4_addr_t buf,
+              l4_uint32_t size);
+  void next_req(unsigned slot);
+  unsigned long completed() const;
+
+  l4_addr_t _base = 0;
+  l4_uint64_t _capacity = 0;
+  l4_uint16_t _avail_idx = 0;
+  l4_uint16_t _used_idx = 0;
+
+  // Read in progress
+  l4_uint64_t _sector = 0;
+  l4_addr_t _dest = 0;
+  unsigned long _size = 0;
+  unsigned long _submitted = 0;
+  unsigned long _req_offs[Max_reqs];
+  unsigned _busy = 0;
+};
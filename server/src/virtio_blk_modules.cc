@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <l4/sys/consts.h>
+
+#include "boot_timing.h"
+#include "dt.h"
+#include "memory.h"
+#include "mod_info.h"
+#include "panic.h"
+#include "region.h"
+#include "support.h"
+#include "timestamp.h"
+#include "virtio_blk_modules.h"
+#ifdef CONFIG_BOOTSTRAP_COMPRESS
+#include "uncompress.h"
+#endif
+
+static char const disk_magic[] = "L4Re-modules ";
+
+/// Name of the regions reserved while the payload is read.
+static char const *const Payload_reg = ".virtio-blk";
+
+/**
+ * Check whether the disk holds a module payload and read its size.
+ */
+bool
+Virtio_blk_modules::check_disk()
+{
+  char hdr[Virtio_blk::Sector_size];
+  if (_disk.capacity() < 2)
+    return false;
+
+  _disk.read(0, hdr, sizeof(hdr));
+  if (memcmp(hdr, disk_magic, sizeof(disk_magic) - 1))
+    return false;
+
+  hdr[sizeof(hdr) - 1] = 0;
+  char *p;
+  _size = strtoul(hdr + sizeof(disk_magic) - 1, &p, 0);
+  if (!_size || (_size + Virtio_blk::Sector_size - 1) / Virtio_blk::Sector_size
+                > _disk.capacity() - 1)
+    {
+      log_warn("virtio-blk: Invalid module payload size %lu.\n", _size);
+      return false;
+    }
+
+  char *e;
+  _hdr_offs = strtoul(p, &e, 0);
+  if (e == p)
+    _hdr_offs = No_hdr_offs;
+  else if ((_hdr_offs & 7) || _hdr_offs + sizeof(Mod_header) > _size)
+    {
+      log_warn("virtio-blk: Invalid module header offset %lu.\n", _hdr_offs);
+      return false;
+    }
+
+  return true;
+}
+
+bool
+Virtio_blk_modules::load(Dt const &dt)
+{
+  if (_probed)
+    return _size > 0;
+
+  _probed = true;
+
+  if (!dt.have_fdt())
+    return false;
+
+  dt.nodes_by_compatible("virtio,mmio", [this](Dt::Node node)
+    {
+      l4_uint64_t addr;
+      if (!node.is_enabled() || !node.get_reg(0, &addr))
+        return Dt::Continue;
+
+      if (!_disk.init_mmio(addr))
+        return Dt::Continue;
+
+      if (!check_disk())
+        {
+          _disk.reset();
+          _size = 0;
+          return Dt::Continue;
+        }
+
+      log_info("  Using module payload (%lu bytes) from virtio-blk at %llx.\n",
+               _size, addr);
+      return Dt::Break;
+    });
+
+  if (!_size)
+    return false;
+
+  read_payload();
+  return true;
+}
+
+/**
+ * Read the payload and switch the image mode over to it.
+ */
+void
+Virtio_blk_modules::read_payload()
+{
+  unsigned long size = (_size + Virtio_blk::Sector_size - 1)
+                       & ~(Virtio_blk::Sector_size - 1UL);
+  l4_addr_t buf = mem_manager->find_free_ram_rev(l4_round_page(size));
+  if (!buf)
+    panic("virtio-blk: Could not allocate %lu bytes for modules.", size);
+
+  // Keep the payload apart from the modules decompressed while reading. The
+  // final module regions are added by the image mode.
+  mem_manager->regions->add(Region::start_size(buf, l4_round_page(size),
+                                               Payload_reg, Region::Boot));
+
+  Mod_header *hdr = _hdr_offs == No_hdr_offs ? read_all(buf, size)
+                                             : read_streamed(buf, size);
+
+  mem_manager->regions->remove_if([](Region const *r)
+    { return r->name() == Payload_reg; });
+
+  // The virtqueue is in bootstrap memory
+  _disk.reset();
+
+  use_modules_infos(hdr);
+}
+
+/**
+ * Read the whole payload and search the module header in it.
+ */
+Mod_header *
+Virtio_blk_modules::read_all(l4_addr_t buf, unsigned long size)
+{
+  _disk.read(1, reinterpret_cast<void *>(buf), size);
+
+  // The module header is 8-byte aligned within the payload
+  char const *p = reinterpret_cast<char const *>(buf);
+  unsigned long offs;
+  for (offs = 0; offs + sizeof(Mod_header) <= _size; offs += 8)
+    if (!memcmp(p + offs, BOOTSTRAP_MOD_INFO_MAGIC_HDR,
+                sizeof(BOOTSTRAP_MOD_INFO_MAGIC_HDR) - 1))
+      break;
+
+  if (offs + sizeof(Mod_header) > _size)
+    panic("virtio-blk: No module header in module payload.");
+
+  return reinterpret_cast<Mod_header *>(buf + offs);
+}
+
+/**
+ * Read the module information first and decompress each module as soon as
+ * its data has been read.
+ *
+ * The module information (header, module list, strings and attributes) is
+ * expected behind the module data, as laid out by the image build. It is
+ * read up front from the header to the end of the payload. The data in front
+ * of it is read afterwards while the modules are decompressed on the boot
+ * CPU, the requests in flight keep the device busy meanwhile.
+ */
+Mod_header *
+Virtio_blk_modules::read_streamed(l4_addr_t buf, unsigned long size)
+{
+  unsigned long info = _hdr_offs & ~(Virtio_blk::Sector_size - 1UL);
+  _disk.read(1 + info / Virtio_blk::Sector_size,
+             reinterpret_cast<void *>(buf + info), size - info);
+
+  auto *hdr = reinterpret_cast<Mod_header *>(buf + _hdr_offs);
+  if (memcmp(hdr, BOOTSTRAP_MOD_INFO_MAGIC_HDR,
+             sizeof(BOOTSTRAP_MOD_INFO_MAGIC_HDR) - 1))
+    panic("virtio-blk: No module header at offset %lu.", _hdr_offs);
+
+  if (reinterpret_cast<l4_addr_t>(hdr->mods().begin()) < buf + info
+      || reinterpret_cast<l4_addr_t>(hdr->mods().end()) > buf + _size)
+    panic("virtio-blk: Module list not behind the module header.");
+
+  _disk.start_read(1, reinterpret_cast<void *>(buf), info);
+
+#ifdef CONFIG_BOOTSTRAP_COMPRESS
+  for (Mod_info &mod : hdr->mods())
+    {
+      if (!mod.compressed())
+        continue;
+
+      // Data in the information part of the payload is already there
+      l4_addr_t end = reinterpret_cast<l4_addr_t>(mod.start()) + mod.size();
+      if (end < buf || end > buf + _size)
+        panic("virtio-blk: Module %d outside of module payload.", mod.index());
+      _disk.wait(end - buf);
+      if (reinterpret_cast<l4_addr_t>(mod.name()) < buf + info)
+        _disk.wait(info);
+
+      inflate(&mod);
+    }
+#endif
+
+  _disk.wait(info);
+  return hdr;
+}
+
+#ifdef CONFIG_BOOTSTRAP_COMPRESS
+/**
+ * Decompress a module of the payload to free RAM.
+ *
+ * The image mode then handles it like an uncompressed module.
+ */
+void
+Virtio_blk_modules::inflate(Mod_info *mod)
+{
+  unsigned long dest_size = l4_round_page(mod->size_uncompressed());
+  l4_addr_t dest = mem_manager->find_free_ram_rev(dest_size);
+  if (!dest)
+    panic("Cannot decompress module: %s (no memory)", mod->name());
+
+  l4_uint64_t start = timestamp();
+  if (decompress(mod->name(), mod->start(), reinterpret_cast<char *>(dest),
+                 mod->size(), mod->size_uncompressed())
+      != reinterpret_cast<void *>(dest))
+    panic("Cannot decompress module: %s (decompression error)", mod->name());
+  Boot_timing::module(Boot_timing::Inflate, mod->name(), start,
+                      mod->size_uncompressed(), mod->size());
+
+  mem_manager->regions->add(Region::start_size(dest, dest_size, Payload_reg,
+                                               Region::Boot));
+  mod->start(reinterpret_cast<char const *>(dest));
+  mod->size(mod->size_uncompressed());
+}
+#endif
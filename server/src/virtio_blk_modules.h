@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2025 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#pragma once
+
+#include "virtio_blk.h"
+
+class Dt;
+class Mod_header;
+class Mod_info;
+
+/**
+ * Module payload read from a virtio block device.
+ *
+ * This allows to boot a small bootstrap without modules and to provide the
+ * modules of an image on a separate disk. The first sector of the disk holds
+ * the text `L4Re-modules <size> [<header offset>]`, followed by the module
+ * payload of a bootstrap image (its `.module_data` section) of `<size>` bytes
+ * starting with the second sector. Such a disk is created with:
+ *
+ *     objcopy -O binary -j .module_data bootstrap_hello.elf mods.bin
+ *     printf 'L4Re-modules %d %d\n' $(stat -c %s mods.bin) \
+ *       $(grep -obUa -- '<< L4Re-bootstrap-modinfo-hdr >>' mods.bin \
+ *         | cut -d: -f1) | dd of=mods.img bs=512 conv=sync
+ *     cat mods.bin >> mods.img
+ *
+ * and attached to QEMU with:
+ *
+ *     -drive if=none,format=raw,file=mods.img,id=mods
+ *     -device virtio-blk-device,drive=mods
+ *
+ * The payload is read to the end of the RAM and replaces the modules linked
+ * into the image. From then on, the modules are handled by the image mode.
+ *
+ * With the offset of the module header, the module information behind the
+ * module data is read first. The modules are then decompressed one after the
+ * other while the remaining payload is read. Without it, the whole payload is
+ * read first and the image mode decompresses the modules.
+ */
+class Virtio_blk_modules
+{
+public:
+  /**
+   * Look for a disk with a module payload on the virtio-mmio transports
+   * listed in the device tree and load it.
+   *
+   * Must be called before the module regions are initialized. Subsequent
+   * calls have no effect.
+   *
+   * \retval true   The modules are provided on a virtio block device.
+   * \retval false  No suitable disk found.
+   */
+  bool load(Dt const &dt);
+
+private:
+  enum : unsigned long { No_hdr_offs = ~0UL };
+
+  bool check_disk();
+  void read_payload();
+  Mod_header *read_all(l4_addr_t buf, unsigned long size);
+  Mod_header *read_streamed(l4_addr_t buf, unsigned long size);
+  void inflate(Mod_info *mod);
+
+  Virtio_blk _disk;
+  unsigned long _size = 0;
+  unsigned long _hdr_offs = No_hdr_offs;
+  bool _probed = false;
+};